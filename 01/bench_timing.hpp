@@ -0,0 +1,29 @@
+/**
+ * Timing helpers shared by the Day 01, Day 02, Day 10 and Day 12 benchmarks
+ * and checks.
+ *
+ * Each benchmark times a few competing implementations of the same step
+ * and reports their throughput side by side; these keep the stopwatch and
+ * the rate arithmetic in one place.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <utility>
+
+// Run fn once and return its result with the elapsed wall time in ms
+template <typename Fn>
+auto timeMs(Fn &&fn)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    auto result = fn();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::make_pair(result, std::chrono::duration<double, std::milli>(end - start).count());
+}
+
+// Throughput in millions of items per second, 0 if the run was too short to time
+inline double millionsPerSecond(double items, double ms)
+{
+    return ms > 0 ? items / (ms / 1000.0) / 1e6 : 0.0;
+}
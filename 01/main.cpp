@@ -3,6 +3,21 @@
 #include <string>
 #include <vector>
 #include <sstream>
+#include <random>
+#include <limits>
+#include <array>
+#include <thread>
+#include <algorithm>
+#include <cstdint>
+#include <chrono>
+#include "bench_timing.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define HAS_AVX2_KERNEL 1
+#else
+#define HAS_AVX2_KERNEL 0
+#endif
 
 using namespace std;
 
@@ -60,11 +75,146 @@ size_t solve_part1(const vector<Rotation> &rotations)
     return count;
 }
 
+// Structure-of-arrays layout for the batch kernels: one signed distance per
+// rotation (positive = right, negative = left).
+vector<int32_t> to_signed_distances(const vector<Rotation> &rotations)
+{
+    vector<int32_t> distances(rotations.size());
+    for (size_t k = 0; k < rotations.size(); k++)
+    {
+        int32_t distance = rotations[k].distance;
+        distances[k] = rotations[k].direction == 'L' ? -distance : distance;
+    }
+    return distances;
+}
+
+// Branch-free scalar version; also handles the tail of the vector kernel
+size_t count_zero_landings_scalar(const int32_t *distances, size_t count, int &dial)
+{
+    size_t zeros = 0;
+    for (size_t k = 0; k < count; k++)
+    {
+        dial = (dial + distances[k] % 100 + 100) % 100;
+        zeros += (dial == 0);
+    }
+    return zeros;
+}
+
+#if HAS_AVX2_KERNEL
+// Processes 8 rotations per iteration: reduce each distance mod 100, take an
+// in-register prefix sum, add the running dial and reduce mod 100 again.
+__attribute__((target("avx2"))) size_t count_zero_landings_avx2(const int32_t *distances, size_t count, int &dial)
+{
+    // Signed division by 100: q = (mulhi(x, 0x51EB851F) >> 5) + (x < 0)
+    const __m256i magic = _mm256_set1_epi32(0x51EB851F);
+    const __m256i hundred = _mm256_set1_epi32(100);
+    const __m256i bias = _mm256_set1_epi32(800);
+    const __m256i small_magic = _mm256_set1_epi32(5243); // x / 100 == (x * 5243) >> 19 for x < 43699
+    const __m256i lane3 = _mm256_set1_epi32(3);
+    const __m256i lane7 = _mm256_set1_epi32(7);
+    const __m256i zero = _mm256_setzero_si256();
+
+    __m256i base = _mm256_set1_epi32(dial);
+    size_t zeros = 0;
+    size_t k = 0;
+
+    for (; k + 8 <= count; k += 8)
+    {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(distances + k));
+
+        // Step in (-100, 100) congruent to x mod 100
+        __m256i even = _mm256_srli_epi64(_mm256_mul_epi32(x, magic), 32);
+        __m256i odd = _mm256_mul_epi32(_mm256_srli_epi64(x, 32), magic);
+        __m256i hi = _mm256_blend_epi32(even, odd, 0xAA);
+        __m256i q = _mm256_sub_epi32(_mm256_srai_epi32(hi, 5), _mm256_srai_epi32(x, 31));
+        __m256i step = _mm256_sub_epi32(x, _mm256_mullo_epi32(q, hundred));
+
+        // Inclusive prefix sum across the 8 lanes
+        step = _mm256_add_epi32(step, _mm256_slli_si256(step, 4));
+        step = _mm256_add_epi32(step, _mm256_slli_si256(step, 8));
+        __m256i carry = _mm256_permutevar8x32_epi32(step, lane3);
+        step = _mm256_add_epi32(step, _mm256_blend_epi32(zero, carry, 0xF0));
+
+        // Positions are in (-800, 900); shift positive and reduce mod 100
+        __m256i pos = _mm256_add_epi32(_mm256_add_epi32(step, base), bias);
+        __m256i pq = _mm256_srli_epi32(_mm256_mullo_epi32(pos, small_magic), 19);
+        pos = _mm256_sub_epi32(pos, _mm256_mullo_epi32(pq, hundred));
+
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(pos, zero)));
+        zeros += __builtin_popcount(mask);
+        base = _mm256_permutevar8x32_epi32(pos, lane7);
+    }
+
+    dial = _mm256_cvtsi256_si32(base);
+    return zeros + count_zero_landings_scalar(distances + k, count - k, dial);
+}
+#endif
+
+// Part 1 over the structure-of-arrays layout, using AVX2 when the CPU has it
+size_t solve_part1_batch(const vector<int32_t> &distances)
+{
+    int dial = 50;
+
+#if HAS_AVX2_KERNEL
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return count_zero_landings_avx2(distances.data(), distances.size(), dial);
+    }
+#endif
+
+    return count_zero_landings_scalar(distances.data(), distances.size(), dial);
+}
+
+// Number of times the dial points at 0 while performing a single rotation
+// (including the final position), computed arithmetically instead of
+// stepping through each click.
+size_t count_zero_hits(int dial, const Rotation &rotation)
+{
+    long long distance = rotation.distance;
+
+    if (rotation.direction == 'L')
+    {
+        // Mirror the dial so a left rotation becomes a right rotation from
+        // the opposite side; 0 stays at 0.
+        long long mirrored = (100 - dial) % 100;
+        return (mirrored + distance) / 100;
+    }
+
+    // 'R'
+    return (dial + distance) / 100;
+}
+
+int apply_rotation(int dial, const Rotation &rotation)
+{
+    int step = rotation.distance % 100;
+    if (rotation.direction == 'L')
+    {
+        return (dial - step + 100) % 100;
+    }
+    return (dial + step) % 100;
+}
+
 size_t solve_part2(const vector<Rotation> &rotations)
 {
     int dial = 50;
     size_t count = 0;
 
+    for (const auto &rotation : rotations)
+    {
+        count += count_zero_hits(dial, rotation);
+        dial = apply_rotation(dial, rotation);
+    }
+
+    return count;
+}
+
+// Reference implementation that steps the dial one click at a time.
+// Only used to cross-check solve_part2.
+size_t solve_part2_stepping(const vector<Rotation> &rotations)
+{
+    int dial = 50;
+    size_t count = 0;
+
     for (const auto &rotation : rotations)
     {
         int start_dial = dial;
@@ -111,6 +261,279 @@ size_t solve_part2(const vector<Rotation> &rotations)
     return count;
 }
 
+// Running state for both parts, so rotations can be consumed one at a time
+// without materializing the whole log.
+struct DialAccumulator
+{
+    int dial = 50;
+    size_t part1 = 0;
+    size_t part2 = 0;
+
+    void apply(const Rotation &rotation)
+    {
+        part2 += count_zero_hits(dial, rotation);
+        dial = apply_rotation(dial, rotation);
+        if (dial == 0)
+        {
+            part1++;
+        }
+    }
+};
+
+// Summary of a contiguous chunk of rotations. Since the dial only moves by
+// offsets mod 100, a chunk is fully described by its net offset plus the
+// number of zero hits for each of the 100 possible starting positions.
+struct ChunkSummary
+{
+    int offset = 0;
+    array<size_t, 100> part1_hits{};
+    array<size_t, 100> part2_hits{};
+};
+
+ChunkSummary summarize_chunk(const Rotation *begin, const Rotation *end)
+{
+    ChunkSummary summary;
+    // Histogram of positions relative to the chunk start (part 1) and a
+    // circular difference array of "extra" wraps per start (part 2)
+    array<size_t, 100> landed{};
+    array<long long, 101> extra{};
+    size_t full_turns = 0;
+    int rel = 0;
+
+    // Add one hit for every start s with (s + rel) % 100 in [lo, lo + len)
+    auto add_interval = [&](int lo, int len)
+    {
+        int first = ((lo - rel) % 100 + 100) % 100;
+        if (first + len <= 100)
+        {
+            extra[first]++;
+            extra[first + len]--;
+        }
+        else
+        {
+            extra[first]++;
+            extra[100]--;
+            extra[0]++;
+            extra[first + len - 100]--;
+        }
+    };
+
+    for (const Rotation *rotation = begin; rotation != end; ++rotation)
+    {
+        full_turns += rotation->distance / 100;
+        int step = rotation->distance % 100;
+
+        if (step > 0)
+        {
+            if (rotation->direction == 'L')
+            {
+                // Passes 0 when the current position is in [1, step]
+                add_interval(1, step);
+                rel = (rel - step + 100) % 100;
+            }
+            else // 'R'
+            {
+                // Passes 0 when the current position is in [100 - step, 99]
+                add_interval(100 - step, step);
+                rel = (rel + step) % 100;
+            }
+        }
+
+        landed[rel]++;
+    }
+
+    long long running = 0;
+    for (int start = 0; start < 100; start++)
+    {
+        running += extra[start];
+        summary.part1_hits[start] = landed[(100 - start) % 100];
+        summary.part2_hits[start] = full_turns + running;
+    }
+    summary.offset = rel;
+
+    return summary;
+}
+
+// Split the log into one chunk per thread, summarize the chunks in parallel,
+// then scan the summaries in order to thread the starting dial through them.
+DialAccumulator solve_parallel(const vector<Rotation> &rotations, unsigned thread_count)
+{
+    thread_count = max(1u, thread_count);
+    size_t chunk_size = (rotations.size() + thread_count - 1) / thread_count;
+    vector<ChunkSummary> summaries(thread_count);
+    vector<thread> workers;
+
+    for (unsigned t = 0; t < thread_count; t++)
+    {
+        size_t from = min(rotations.size(), t * chunk_size);
+        size_t to = min(rotations.size(), from + chunk_size);
+        workers.emplace_back([&, t, from, to]()
+                             { summaries[t] = summarize_chunk(rotations.data() + from, rotations.data() + to); });
+    }
+
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+
+    DialAccumulator result;
+    for (const auto &summary : summaries)
+    {
+        result.part1 += summary.part1_hits[result.dial];
+        result.part2 += summary.part2_hits[result.dial];
+        result.dial = (result.dial + summary.offset) % 100;
+    }
+
+    return result;
+}
+
+// Parse L/R records from the file through a fixed-size buffer, feeding each
+// one straight into the accumulator. Memory use does not depend on the size
+// of the log and nothing is allocated per line.
+DialAccumulator solve_stream(const string &path)
+{
+    ifstream file(path, ios::binary);
+    if (!file.is_open())
+    {
+        throw runtime_error("Failed to read file: " + path);
+    }
+
+    const size_t BUFFER_SIZE = 1 << 16;
+    vector<char> buffer(BUFFER_SIZE);
+    DialAccumulator accumulator;
+
+    // Parser state carried across buffer boundaries
+    char direction = 0;
+    long long distance = 0;
+    bool has_digits = false;
+    size_t line_number = 1;
+
+    auto finish_record = [&]()
+    {
+        if (direction == 0)
+            return; // blank line
+
+        if (!has_digits || distance > numeric_limits<int>::max())
+        {
+            throw runtime_error("Invalid rotation on line " + to_string(line_number));
+        }
+
+        accumulator.apply({direction, (int)distance});
+        direction = 0;
+        distance = 0;
+        has_digits = false;
+    };
+
+    while (file)
+    {
+        file.read(buffer.data(), BUFFER_SIZE);
+        streamsize bytes = file.gcount();
+
+        for (streamsize k = 0; k < bytes; k++)
+        {
+            char c = buffer[k];
+
+            if (c >= '0' && c <= '9' && direction != 0)
+            {
+                // Saturate so an absurdly long number is reported, not wrapped
+                if (distance <= numeric_limits<int>::max())
+                {
+                    distance = distance * 10 + (c - '0');
+                }
+                has_digits = true;
+            }
+            else if ((c == 'L' || c == 'R') && direction == 0)
+            {
+                direction = c;
+            }
+            else if (c == '\n')
+            {
+                finish_record();
+                line_number++;
+            }
+            else if (c != '\r' && c != ' ' && c != '\t')
+            {
+                throw runtime_error("Unexpected character on line " + to_string(line_number));
+            }
+        }
+    }
+
+    // Last record may not end with a newline
+    finish_record();
+
+    return accumulator;
+}
+
+// Differential test: compare solve_part2, solve_parallel and the batch
+// kernel against the reference loops on randomized rotation streams. Returns the number of mismatching streams.
+int cross_check_part2(int streams, unsigned seed)
+{
+    mt19937 rng(seed);
+    uniform_int_distribution<int> direction_dist(0, 1);
+    uniform_int_distribution<int> length_dist(1, 200);
+    // Mix short turns with long multi-revolution ones so both code paths
+    // (partial and full wrap-arounds) are covered.
+    uniform_int_distribution<int> short_dist(0, 199);
+    uniform_int_distribution<int> long_dist(0, 20000);
+    int mismatches = 0;
+
+    for (int s = 0; s < streams; s++)
+    {
+        vector<Rotation> rotations(length_dist(rng));
+        for (auto &rotation : rotations)
+        {
+            rotation.direction = direction_dist(rng) ? 'R' : 'L';
+            rotation.distance = (rng() % 4 == 0) ? long_dist(rng) : short_dist(rng);
+        }
+
+        size_t expected = solve_part2_stepping(rotations);
+        size_t actual = solve_part2(rotations);
+        DialAccumulator parallel = solve_parallel(rotations, 1 + s % 7);
+        if (expected != actual || parallel.part2 != expected ||
+            parallel.part1 != solve_part1(rotations) ||
+            solve_part1_batch(to_signed_distances(rotations)) != parallel.part1)
+        {
+            cout << "MISMATCH in stream " << s << ": expected " << expected
+                 << ", got " << actual << " (parallel " << parallel.part2 << ")" << endl;
+            mismatches++;
+        }
+    }
+
+    return mismatches;
+}
+
+// Benchmark: rotations per second of solve_part1 versus the batch kernel
+void run_benchmark(size_t count)
+{
+    mt19937 rng(7);
+    vector<Rotation> rotations(count);
+    for (auto &rotation : rotations)
+    {
+        rotation.direction = (rng() & 1) ? 'R' : 'L';
+        rotation.distance = rng() % 1000000;
+    }
+
+    auto [scalar_result, scalar_ms] = timeMs([&]()
+                                             { return solve_part1(rotations); });
+    auto [distances, layout_ms] = timeMs([&]()
+                                         { return to_signed_distances(rotations); });
+    auto [batch_result, batch_ms] = timeMs([&]()
+                                           { return solve_part1_batch(distances); });
+
+    auto rate = [count](double ms)
+    { return millionsPerSecond(count, ms); };
+
+    cout << "Rotations: " << count << endl;
+    cout << "solve_part1:        " << scalar_ms << " ms (" << rate(scalar_ms) << " M rotations/s)" << endl;
+    cout << "to_signed_distances: " << layout_ms << " ms" << endl;
+    cout << "solve_part1_batch:  " << batch_ms << " ms (" << rate(batch_ms) << " M rotations/s)" << endl;
+
+    if (scalar_result != batch_result)
+    {
+        cout << "ERROR: Batch result " << batch_result << " does not match " << scalar_result << endl;
+    }
+}
+
 string read_file(const string &path)
 {
     ifstream file(path);
@@ -123,8 +546,34 @@ string read_file(const string &path)
     return buffer.str();
 }
 
-int main()
+int main(int argc, char *argv[])
 {
+    // Streaming mode: solve an arbitrarily large log in constant memory
+    if (argc > 2 && string(argv[1]) == "stream")
+    {
+        DialAccumulator result = solve_stream(argv[2]);
+        cout << "Part 1 answer: " << result.part1 << endl;
+        cout << "Part 2 answer: " << result.part2 << endl;
+        return 0;
+    }
+
+    // Benchmark mode: compare part 1 loops on a random log
+    if (argc > 1 && string(argv[1]) == "bench")
+    {
+        size_t count = (argc > 2) ? stoull(argv[2]) : 50000000;
+        run_benchmark(count);
+        return 0;
+    }
+
+    // Check mode: full differential test against the reference loops
+    if (argc > 1 && string(argv[1]) == "check")
+    {
+        int streams = (argc > 2) ? stoi(argv[2]) : 2000;
+        int mismatches = cross_check_part2(streams, 2025);
+        cout << "Streams: " << streams << ", mismatches: " << mismatches << endl;
+        return mismatches == 0 ? 0 : 1;
+    }
+
     cout << "=== Part 1 ===" << endl;
 
     // Run example.txt first
@@ -174,9 +623,67 @@ int main()
          << endl;
 
     // Run input.txt for part 2
+    // Cross-check the closed-form counter against the stepping reference
+    cout << "Cross-checking against stepping reference..." << endl;
+    // A quick sample; 'check' mode runs the full differential test
+    const int CROSS_CHECK_STREAMS = 50;
+    if (cross_check_part2(CROSS_CHECK_STREAMS, 2025) != 0 ||
+        solve_part2_stepping(example_rotations) != example2_result)
+    {
+        cout << "ERROR: Closed-form result differs from stepping reference. Stopping." << endl;
+        return 1;
+    }
+
+    cout << "OK: " << CROSS_CHECK_STREAMS << " random streams match!" << endl
+         << endl;
+
     cout << "Running input.txt..." << endl;
     size_t input_result2 = solve_part2(input_rotations);
-    cout << "Part 2 answer: " << input_result2 << endl;
+    cout << "Part 2 answer: " << input_result2 << endl
+         << endl;
+
+    cout << "=== Streaming ===" << endl;
+
+    // The streaming parser must agree with the in-memory path
+    cout << "Running input.txt..." << endl;
+    DialAccumulator streamed = solve_stream("01/input.txt");
+    if (streamed.part1 != input_result || streamed.part2 != input_result2)
+    {
+        cout << "ERROR: Streaming results " << streamed.part1 << ", " << streamed.part2
+             << " do not match " << input_result << ", " << input_result2 << ". Stopping." << endl;
+        return 1;
+    }
+
+    cout << "OK: Streaming results match!" << endl
+         << endl;
+
+    cout << "=== Parallel ===" << endl;
+
+    unsigned thread_count = max(1u, thread::hardware_concurrency());
+    cout << "Running input.txt on " << thread_count << " threads..." << endl;
+    DialAccumulator parallel = solve_parallel(input_rotations, thread_count);
+    if (parallel.part1 != input_result || parallel.part2 != input_result2)
+    {
+        cout << "ERROR: Parallel results " << parallel.part1 << ", " << parallel.part2
+             << " do not match " << input_result << ", " << input_result2 << ". Stopping." << endl;
+        return 1;
+    }
+
+    cout << "OK: Parallel results match!" << endl
+         << endl;
+
+    cout << "=== Batch kernel ===" << endl;
+
+    cout << "Running input.txt..." << endl;
+    size_t batch_result = solve_part1_batch(to_signed_distances(input_rotations));
+    if (batch_result != input_result)
+    {
+        cout << "ERROR: Batch result " << batch_result << " does not match "
+             << input_result << ". Stopping." << endl;
+        return 1;
+    }
+
+    cout << "OK: Batch result matches!" << endl;
 
     return 0;
 }
@@ -4,6 +4,10 @@
 #include <vector>
 #include <sstream>
 #include <chrono>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include "../01/bench_timing.hpp"
 
 using namespace std;
 
@@ -50,7 +54,108 @@ vector<Range> parse_input(const string &content)
     return ranges;
 }
 
+// Sort the ranges and coalesce overlapping or adjacent ones, so no ID is
+// visited (or counted) twice
+vector<Range> merge_ranges(vector<Range> ranges)
+{
+    sort(ranges.begin(), ranges.end(), [](const Range &a, const Range &b)
+         { return a.start < b.start; });
+
+    vector<Range> merged;
+    for (const auto &range : ranges)
+    {
+        if (!merged.empty() && range.start <= merged.back().end + 1)
+        {
+            merged.back().end = max(merged.back().end, range.end);
+        }
+        else
+        {
+            merged.push_back(range);
+        }
+    }
+
+    return merged;
+}
+
+// Powers of ten and repunit multipliers (10^len - 1) / (10^p - 1), i.e.
+// 1 + 10^p + 10^2p + ... up to len digits, for every p dividing len
+struct DigitTables
+{
+    unsigned long long pow10[20];
+    unsigned long long repunit[20][20];
+};
+
+constexpr DigitTables make_digit_tables()
+{
+    DigitTables tables{};
+    tables.pow10[0] = 1;
+    for (int i = 1; i < 20; i++)
+    {
+        tables.pow10[i] = tables.pow10[i - 1] * 10;
+    }
+
+    for (int len = 1; len < 20; len++)
+    {
+        for (int p = 1; p < len; p++)
+        {
+            if (len % p != 0)
+                continue;
+
+            unsigned long long multiplier = 0;
+            for (int shift = 0; shift < len; shift += p)
+            {
+                multiplier += tables.pow10[shift];
+            }
+            tables.repunit[len][p] = multiplier;
+        }
+    }
+
+    return tables;
+}
+
+constexpr DigitTables DIGIT_TABLES = make_digit_tables();
+
+int count_digits(unsigned long long num)
+{
+    int len = 1;
+    while (len < 20 && num >= DIGIT_TABLES.pow10[len])
+    {
+        len++;
+    }
+    return len;
+}
+
+// A len-digit number is a p-digit block repeated iff it is divisible by the
+// repunit multiplier: the quotient is then the block itself.
 bool is_repeated_pattern_part1(long long num)
+{
+    if (num < 0)
+        return false;
+
+    int len = count_digits(num);
+    if (len % 2 != 0)
+        return false;
+
+    return num % DIGIT_TABLES.repunit[len][len / 2] == 0;
+}
+
+bool is_repeated_pattern_part2(long long num)
+{
+    if (num < 0)
+        return false;
+
+    int len = count_digits(num);
+    for (int pattern_len = 1; pattern_len <= len / 2; pattern_len++)
+    {
+        if (len % pattern_len == 0 && num % DIGIT_TABLES.repunit[len][pattern_len] == 0)
+            return true;
+    }
+
+    return false;
+}
+
+// String-based predicates, kept as the baseline for the benchmark
+bool is_repeated_pattern_part1_string(long long num)
 {
     string s = to_string(num);
     int len = s.length();
@@ -66,7 +171,7 @@ bool is_repeated_pattern_part1(long long num)
     return first_half == second_half;
 }
 
-bool is_repeated_pattern_part2(long long num)
+bool is_repeated_pattern_part2_string(long long num)
 {
     string s = to_string(num);
     int len = s.length();
@@ -96,42 +201,238 @@ bool is_repeated_pattern_part2(long long num)
     return false;
 }
 
+// ==================================
+// Arithmetic enumeration
+// ==================================
+//
+// An ID with `digits` digits made of a `pattern_len`-digit block repeated is
+// pattern * (10^(digits - pattern_len) + ... + 10^pattern_len + 1), i.e.
+// pattern * (10^digits - 1) / (10^pattern_len - 1). For a range this means the
+// valid patterns form a contiguous interval, so their sum is an arithmetic
+// series and no ID has to be visited individually.
+
+typedef __int128 int128;
+
+const int MAX_DIGITS = 19; // long long holds at most 19 decimal digits
+
+int128 pow10_128(int exponent)
+{
+    int128 result = 1;
+    for (int i = 0; i < exponent; i++)
+    {
+        result *= 10;
+    }
+    return result;
+}
+
+// Sum of all IDs in [lo, hi] with exactly `digits` digits that consist of a
+// `pattern_len`-digit block repeated digits / pattern_len times
+int128 sum_repeated(long long lo, long long hi, int digits, int pattern_len)
+{
+    int128 multiplier = (pow10_128(digits) - 1) / (pow10_128(pattern_len) - 1);
+
+    // Patterns must have exactly pattern_len digits (no leading zero)
+    int128 first = max<int128>(pow10_128(pattern_len - 1), (lo + multiplier - 1) / multiplier);
+    int128 last = min<int128>(pow10_128(pattern_len) - 1, hi / multiplier);
+
+    if (lo < 0 || first > last)
+        return 0;
+
+    return multiplier * (first + last) * (last - first + 1) / 2;
+}
+
+vector<int> prime_factors(int n)
+{
+    vector<int> primes;
+    for (int p = 2; p * p <= n; p++)
+    {
+        if (n % p == 0)
+        {
+            primes.push_back(p);
+            while (n % p == 0)
+                n /= p;
+        }
+    }
+    if (n > 1)
+        primes.push_back(n);
+    return primes;
+}
+
 long long solve_part1(const vector<Range> &ranges)
 {
-    long long total = 0;
+    int128 total = 0;
 
     for (const auto &range : ranges)
     {
-        for (long long id = range.start; id <= range.end; id++)
+        // Exactly two copies of a half-length block
+        for (int digits = 2; digits <= MAX_DIGITS; digits += 2)
         {
-            if (is_repeated_pattern_part1(id))
+            total += sum_repeated(range.start, range.end, digits, digits / 2);
+        }
+    }
+
+    return (long long)total;
+}
+
+long long solve_part2(const vector<Range> &ranges)
+{
+    int128 total = 0;
+
+    for (const auto &range : ranges)
+    {
+        for (int digits = 2; digits <= MAX_DIGITS; digits++)
+        {
+            // An ID repeats with some block length iff it repeats with block
+            // length digits / q for a prime q dividing digits. Repeating with
+            // both d1 and d2 implies repeating with gcd(d1, d2), so overlaps
+            // are removed by inclusion-exclusion over subsets of those primes.
+            vector<int> primes = prime_factors(digits);
+            for (int subset = 1; subset < (1 << primes.size()); subset++)
             {
-                total += id;
+                int product = 1;
+                int bits = 0;
+                for (size_t k = 0; k < primes.size(); k++)
+                {
+                    if (subset & (1 << k))
+                    {
+                        product *= primes[k];
+                        bits++;
+                    }
+                }
+
+                int128 sum = sum_repeated(range.start, range.end, digits, digits / product);
+                total += (bits % 2 == 1) ? sum : -sum;
             }
         }
     }
 
-    return total;
+    return (long long)total;
 }
 
-long long solve_part2(const vector<Range> &ranges)
+// ==================================
+// Brute-force reference
+// ==================================
+
+// Split the ranges into `shard_count` pieces covering about the same number
+// of IDs each, cutting ranges where needed
+vector<vector<Range>> shard_ranges(const vector<Range> &ranges, size_t shard_count)
 {
-    long long total = 0;
+    long long total_ids = 0;
+    for (const auto &range : ranges)
+    {
+        total_ids += range.end - range.start + 1;
+    }
+
+    long long per_shard = max(1LL, (total_ids + (long long)shard_count - 1) / (long long)shard_count);
+    vector<vector<Range>> shards(1);
+    long long room = per_shard;
 
     for (const auto &range : ranges)
     {
-        for (long long id = range.start; id <= range.end; id++)
+        long long start = range.start;
+        while (start <= range.end)
         {
-            if (is_repeated_pattern_part2(id))
+            if (room == 0)
             {
-                total += id;
+                shards.emplace_back();
+                room = per_shard;
             }
+
+            long long end = min(range.end, start + room - 1);
+            shards.back().push_back({start, end});
+            room -= end - start + 1;
+            start = end + 1;
         }
     }
 
+    return shards;
+}
+
+// Sum every ID matching the predicate, with shards handed out to a pool of
+// worker threads and each worker keeping its own partial sum
+long long scan_sum(const vector<Range> &ranges, bool (*predicate)(long long))
+{
+    unsigned thread_count = max(1u, thread::hardware_concurrency());
+    // A few shards per thread so uneven predicate cost still balances out
+    vector<vector<Range>> shards = shard_ranges(ranges, thread_count * 4);
+    vector<long long> partial_sums(thread_count, 0);
+    atomic<size_t> next_shard{0};
+    vector<thread> workers;
+
+    for (unsigned t = 0; t < thread_count; t++)
+    {
+        workers.emplace_back([&, t]()
+                             {
+            size_t shard;
+            while ((shard = next_shard.fetch_add(1)) < shards.size())
+            {
+                for (const auto &range : shards[shard])
+                {
+                    for (long long id = range.start; id <= range.end; id++)
+                    {
+                        if (predicate(id))
+                        {
+                            partial_sums[t] += id;
+                        }
+                    }
+                }
+            } });
+    }
+
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+
+    long long total = 0;
+    for (long long sum : partial_sums)
+    {
+        total += sum;
+    }
+
     return total;
 }
 
+long long solve_part1_scan(const vector<Range> &ranges)
+{
+    return scan_sum(ranges, is_repeated_pattern_part1);
+}
+
+long long solve_part2_scan(const vector<Range> &ranges)
+{
+    return scan_sum(ranges, is_repeated_pattern_part2);
+}
+
+// Microbenchmark: integer predicates versus the string-based ones
+void run_benchmark(long long first_id, long long count)
+{
+    cout << "IDs: " << first_id << " .. " << first_id + count - 1 << endl;
+
+    auto report = [&](const string &name, bool (*predicate)(long long))
+    {
+        auto [matches, ms] = timeMs([&]()
+                                    {
+            long long found = 0;
+            for (long long id = first_id; id < first_id + count; id++)
+            {
+                found += predicate(id);
+            }
+            return found; });
+        cout << name << matches << " matches, " << ms << " ms (" << millionsPerSecond(count, ms) << " M IDs/s)" << endl;
+        return matches;
+    };
+
+    long long s1 = report("part1 string:  ", is_repeated_pattern_part1_string);
+    long long i1 = report("part1 integer: ", is_repeated_pattern_part1);
+    long long s2 = report("part2 string:  ", is_repeated_pattern_part2_string);
+    long long i2 = report("part2 integer: ", is_repeated_pattern_part2);
+
+    if (s1 != i1 || s2 != i2)
+    {
+        cout << "ERROR: Integer predicates disagree with string predicates" << endl;
+    }
+}
+
 string read_file(const string &path)
 {
     ifstream file(path);
@@ -144,14 +445,58 @@ string read_file(const string &path)
     return buffer.str();
 }
 
-int main()
+// Check mode: compare the enumeration with the brute-force scan on a full
+// input. The scan walks every ID in every range, so it is kept out of the
+// default run.
+int run_check(const string &path)
+{
+    vector<Range> ranges = merge_ranges(parse_input(read_file(path)));
+
+    auto compare = [&](const string &name, long long (*solve)(const vector<Range> &),
+                       long long (*scan)(const vector<Range> &))
+    {
+        long long result = solve(ranges);
+        auto [scan_result, scan_ms] = timeMs([&]()
+                                             { return scan(ranges); });
+
+        cout << name << result << ", brute-force scan: " << scan_result
+             << " (" << scan_ms << " ms)" << endl;
+        return result == scan_result;
+    };
+
+    bool part1_ok = compare("Part 1 enumeration: ", solve_part1, solve_part1_scan);
+    bool part2_ok = compare("Part 2 enumeration: ", solve_part2, solve_part2_scan);
+    if (!part1_ok || !part2_ok)
+    {
+        cout << "ERROR: Enumeration differs from brute-force scan." << endl;
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
 {
+    // Benchmark mode: time the repetition predicates
+    if (argc > 1 && string(argv[1]) == "bench")
+    {
+        long long first_id = (argc > 2) ? stoll(argv[2]) : 5353503564;
+        long long count = (argc > 3) ? stoll(argv[3]) : 20000000;
+        run_benchmark(first_id, count);
+        return 0;
+    }
+
+    // Check mode: brute-force scan of the whole input
+    if (argc > 1 && string(argv[1]) == "check")
+    {
+        return run_check((argc > 2) ? argv[2] : "02/input.txt");
+    }
+
     cout << "=== Part 1 ===" << endl;
 
     // Run example.txt first
     cout << "Running example.txt..." << endl;
     string example_content = read_file("02/example.txt");
-    vector<Range> example_ranges = parse_input(example_content);
+    vector<Range> example_ranges = merge_ranges(parse_input(example_content));
 
     auto start_time = chrono::high_resolution_clock::now();
     long long example_result = solve_part1(example_ranges);
@@ -173,10 +518,17 @@ int main()
     cout << "✓ Example result is correct!" << endl
          << endl;
 
+    // Cross-check the arithmetic enumeration against the brute-force scan
+    if (solve_part1_scan(example_ranges) != example_result)
+    {
+        cout << "ERROR: Enumeration differs from brute-force scan. Stopping." << endl;
+        return 1;
+    }
+
     // Run input.txt
     cout << "Running input.txt..." << endl;
     string input_content = read_file("02/input.txt");
-    vector<Range> input_ranges = parse_input(input_content);
+    vector<Range> input_ranges = merge_ranges(parse_input(input_content));
 
     start_time = chrono::high_resolution_clock::now();
     long long input_result = solve_part1(input_ranges);
@@ -211,6 +563,13 @@ int main()
     cout << "✓ Example result is correct!" << endl
          << endl;
 
+    // Cross-check the arithmetic enumeration against the brute-force scan
+    if (solve_part2_scan(example_ranges) != example2_result)
+    {
+        cout << "ERROR: Enumeration differs from brute-force scan. Stopping." << endl;
+        return 1;
+    }
+
     // Run input.txt for part 2
     cout << "Running input.txt..." << endl;
     start_time = chrono::high_resolution_clock::now();
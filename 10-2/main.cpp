@@ -11,6 +11,8 @@
  * - Each button is a variable (number of presses)
  * - Each joltage counter is an equation
  * - Solve using Gaussian elimination (standard arithmetic, not GF(2))
+ * - Minimize the presses exactly with branch and bound over the free
+ *   variables, pruned by the LP relaxation (a small dense simplex)
  */
 
 #include <iostream>
@@ -18,14 +20,26 @@
 #include <sstream>
 #include <vector>
 #include <string>
-#include <regex>
 #include <algorithm>
 #include <limits>
 #include <numeric>
 #include <functional>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <list>
+#include <random>
+
+#include "../10/machine.hpp"
+#include "../10/work_stealing.hpp"
 
 using namespace std;
 
+typedef __int128 int128;
+
 // ==================================
 // Utility functions
 // ==================================
@@ -65,98 +79,101 @@ vector<string> readLines(const string &filename)
 // Problem-specific code
 // ==================================
 
-// Parsing helpers
-auto extractJoltageRequirements = [](const string &line) -> vector<int>
+// Build the matrix [A | I] for the additive system: A has a row per joltage
+// counter and a column per button; the identity block records the row
+// operations, so after elimination it holds T with T * A = reduced A and
+// any target vector t can be reduced later as T * t
+auto buildJoltageMatrix = [](int numJoltages, const vector<uint64_t> &buttons)
 {
-    regex joltageRegex(R"(\{([0-9,]+)\})");
-    smatch joltageMatch;
-    if (regex_search(line, joltageMatch, joltageRegex))
-    {
-        const string &reqs = joltageMatch[1].str();
-        vector<int> result;
-        stringstream ss(reqs);
-        string num;
-        while (getline(ss, num, ','))
-        {
-            result.push_back(stoi(num));
-        }
-        return result;
-    }
-    return {};
-};
+    const int numButtons = buttons.size();
 
-auto extractButtons = [](const string &line) -> vector<vector<int>>
-{
-    regex buttonRegex(R"(\(([0-9,]+)\))");
-    smatch buttonMatch;
-    vector<vector<int>> buttons;
-    string::const_iterator searchStart(line.cbegin());
+    vector<vector<long long>> matrix(numJoltages, vector<long long>(numButtons + numJoltages, 0));
 
-    while (regex_search(searchStart, line.cend(), buttonMatch, buttonRegex))
+    for (int jIdx = 0; jIdx < numJoltages; ++jIdx)
     {
-        vector<int> button;
-        stringstream ss(buttonMatch[1].str());
-        string num;
-        while (getline(ss, num, ','))
+        for (int b = 0; b < numButtons; ++b)
         {
-            button.push_back(stoi(num));
+            matrix[jIdx][b] = (buttons[b] >> jIdx) & 1;
         }
-        buttons.push_back(move(button));
-        searchStart = buttonMatch.suffix().first;
+
+        matrix[jIdx][numButtons + jIdx] = 1;
     }
-    return buttons;
-};
 
-struct Machine
-{
-    vector<int> joltage;
-    vector<vector<int>> buttons;
+    return matrix;
 };
 
-Machine parseLine(const string &line)
+// a * b - c * d, or false if any step overflows T
+template <typename T>
+bool mulSubChecked(T a, T b, T c, T d, T &out)
 {
-    return Machine{
-        extractJoltageRequirements(line),
-        extractButtons(line)};
+    T left, right;
+    return !__builtin_mul_overflow(a, b, &left) &&
+           !__builtin_mul_overflow(c, d, &right) &&
+           !__builtin_sub_overflow(left, right, &out);
 }
 
-// Build matrix for additive system (joltage counters)
-auto buildJoltageMatrix = [](const Machine &machine)
+// |value|, or false if it does not fit (the most negative value)
+template <typename T>
+bool absChecked(T value, T &out)
 {
-    const int numJoltages = machine.joltage.size();
-    const int numButtons = machine.buttons.size();
-
-    vector<vector<long long>> matrix(numJoltages, vector<long long>(numButtons + 1, 0));
+    if (value >= 0)
+    {
+        out = value;
+        return true;
+    }
+    return !__builtin_sub_overflow(T(0), value, &out);
+}
 
-    // Populate matrix: each button is a column, each joltage is a row
-    for (int b = 0; b < numButtons; ++b)
+template <typename T>
+T gcdOf(T a, T b)
+{
+    while (b != 0)
     {
-        for (int jIdx : machine.buttons[b])
-        {
-            if (jIdx < numJoltages)
-                matrix[jIdx][b] = 1;
-        }
+        T r = a % b;
+        a = b;
+        b = r;
     }
+    return a;
+}
 
-    // Add target joltages as augmented column
-    for (int i = 0; i < numJoltages; ++i)
+// Divide a row by the gcd of its entries so coefficients stay small
+template <typename T>
+bool normalizeRow(vector<T> &row)
+{
+    T divisor = 0;
+    for (T value : row)
     {
-        matrix[i][numButtons] = machine.joltage[i];
+        T magnitude;
+        if (!absChecked(value, magnitude))
+            return false;
+        divisor = gcdOf(divisor, magnitude);
     }
 
-    return matrix;
-};
+    if (divisor > 1)
+    {
+        for (T &value : row)
+            value /= divisor;
+    }
+    return true;
+}
 
-// Gaussian elimination for integer linear equations
-auto performGaussianElimination = [](vector<vector<long long>> matrix)
+// Fraction-free (Bareiss) Gauss-Jordan elimination with checked arithmetic,
+// pivoting on the first numPivotCols columns. Every row other than the
+// pivot row becomes
+//   (pivot * row - row[col] * pivotRow) / previousPivot
+// where the division is exact, so entries stay bounded by minors of the
+// original matrix instead of growing exponentially. Rows are divided by the
+// gcd of their entries at the end. Returns false if any intermediate value
+// would overflow T.
+template <typename T>
+bool eliminateChecked(vector<vector<T>> &matrix, int numPivotCols, int &rank)
 {
     const int numJoltages = matrix.size();
-    const int numButtons = matrix[0].size() - 1;
+    const int numCols = numJoltages > 0 ? matrix[0].size() : 0;
+    T previousPivot = 1;
+    rank = 0;
 
-    int rank = 0;
-    vector<int> pivotCol(numJoltages, -1);
-
-    for (int col = 0; col < numButtons && rank < numJoltages; ++col)
+    for (int col = 0; col < numPivotCols && rank < numJoltages; ++col)
     {
         // Find pivot with non-zero value
         int pivotRow = -1;
@@ -173,192 +190,944 @@ auto performGaussianElimination = [](vector<vector<long long>> matrix)
             continue;
 
         swap(matrix[rank], matrix[pivotRow]);
-        pivotCol[rank] = col;
+        const T pivot = matrix[rank][col];
 
         // Eliminate this column in all other rows
-        long long pivot = matrix[rank][col];
         for (int i = 0; i < numJoltages; ++i)
         {
-            if (i != rank && matrix[i][col] != 0)
+            if (i == rank)
+                continue;
+
+            const T factor = matrix[i][col];
+            for (int j = 0; j < numCols; ++j)
             {
-                long long factor = matrix[i][col];
-                for (int j = 0; j <= numButtons; ++j)
-                {
-                    matrix[i][j] = matrix[i][j] * pivot - matrix[rank][j] * factor;
-                }
+                T value;
+                if (!mulSubChecked(matrix[i][j], pivot, matrix[rank][j], factor, value))
+                    return false;
+                if (value % previousPivot != 0)
+                    throw logic_error("Inexact division in fraction-free elimination");
+                matrix[i][j] = value / previousPivot;
             }
         }
 
+        previousPivot = pivot;
         rank++;
     }
 
-    return make_pair(matrix, rank);
+    for (auto &row : matrix)
+    {
+        if (!normalizeRow(row))
+            return false;
+    }
+
+    return true;
+}
+
+template <typename To, typename From>
+vector<vector<To>> convertMatrix(const vector<vector<From>> &matrix)
+{
+    vector<vector<To>> result;
+    for (const auto &row : matrix)
+        result.emplace_back(row.begin(), row.end());
+    return result;
+}
+
+// Eliminate on int64 when the coefficients fit, otherwise redo it on
+// __int128; the result is always returned as __int128
+auto performGaussianElimination = [](const vector<vector<long long>> &matrix, int numPivotCols)
+{
+    int rank = 0;
+
+    vector<vector<long long>> narrow = matrix;
+    if (eliminateChecked(narrow, numPivotCols, rank))
+        return make_pair(convertMatrix<int128>(narrow), rank);
+
+    vector<vector<int128>> wide = convertMatrix<int128>(matrix);
+    if (eliminateChecked(wide, numPivotCols, rank))
+        return make_pair(wide, rank);
+
+    throw runtime_error("Coefficient overflow during elimination");
 };
 
-// Check inconsistency in augmented matrix
-auto hasInconsistency = [](const pair<vector<vector<long long>>, int> &state)
+// Rows past the rank reduce to 0 = rhs, which is impossible unless rhs is 0
+auto hasInconsistency = [](const vector<int128> &reducedTarget, int rank)
 {
-    const auto &matrix = state.first;
-    const int rank = state.second;
-    const int numButtons = matrix[0].size() - 1;
+    return any_of(reducedTarget.begin() + rank, reducedTarget.end(),
+                  [](int128 value)
+                  { return value != 0; });
+};
 
-    // Check for rows like [0 0 0 ... | non-zero], which is impossible
-    for (int i = rank; i < (int)matrix.size(); ++i)
+// Dense two-phase simplex: maximize c.x subject to A.x <= b, x >= 0.
+// Uses Bland's rule, so it cannot cycle; the systems here are tiny.
+class LinearProgram
+{
+public:
+    static constexpr double EPS = 1e-9;
+
+    LinearProgram(const vector<vector<double>> &A, const vector<double> &b, const vector<double> &c)
+        : m(b.size()), n(c.size()), basis(m), nonBasis(n + 1), table(m + 2, vector<double>(n + 2, 0.0))
     {
-        bool allZero = true;
-        for (int j = 0; j < numButtons; ++j)
+        for (int i = 0; i < m; ++i)
+        {
+            for (int j = 0; j < n; ++j)
+                table[i][j] = A[i][j];
+            basis[i] = n + i;
+            table[i][n] = -1;
+            table[i][n + 1] = b[i];
+        }
+        for (int j = 0; j < n; ++j)
+        {
+            nonBasis[j] = j;
+            table[m][j] = -c[j];
+        }
+        nonBasis[n] = -1;
+        table[m + 1][n] = 1;
+    }
+
+    // Returns false if infeasible; the problems built here are never
+    // unbounded because every variable has an upper bound.
+    bool solve(double &value, vector<double> &x)
+    {
+        int r = 0;
+        for (int i = 1; i < m; ++i)
+        {
+            if (table[i][n + 1] < table[r][n + 1])
+                r = i;
+        }
+
+        // Phase 1: find a feasible basis when the origin is not one
+        if (m > 0 && table[r][n + 1] < -EPS)
         {
-            if (matrix[i][j] != 0)
+            pivot(r, n);
+            if (!simplex(1) || table[m + 1][n + 1] < -EPS)
+                return false;
+
+            for (int i = 0; i < m; ++i)
             {
-                allZero = false;
-                break;
+                if (basis[i] == -1)
+                {
+                    int s = -1;
+                    for (int j = 0; j <= n; ++j)
+                    {
+                        if (s == -1 || table[i][j] < table[i][s] ||
+                            (table[i][j] == table[i][s] && nonBasis[j] < nonBasis[s]))
+                            s = j;
+                    }
+                    pivot(i, s);
+                }
             }
         }
-        if (allZero && matrix[i][numButtons] != 0)
+
+        if (!simplex(2))
+            return false;
+
+        x.assign(n, 0.0);
+        for (int i = 0; i < m; ++i)
         {
-            return true;
+            if (basis[i] < n)
+                x[basis[i]] = table[i][n + 1];
         }
+        value = table[m][n + 1];
+        return true;
     }
-    return false;
-};
 
-// Core solver - find minimum nonnegative integer solution
-long long findMinPresses(const Machine &machine)
-{
-    const int numJoltages = machine.joltage.size();
-    const int numButtons = machine.buttons.size();
+private:
+    int m, n;
+    vector<int> basis, nonBasis;
+    vector<vector<double>> table;
 
-    auto matrix = buildJoltageMatrix(machine);
-    auto [eliminatedMatrix, rank] = performGaussianElimination(matrix);
+    void pivot(int r, int s)
+    {
+        const double inv = 1.0 / table[r][s];
+        for (int i = 0; i < m + 2; ++i)
+        {
+            if (i == r)
+                continue;
+            for (int j = 0; j < n + 2; ++j)
+            {
+                if (j != s)
+                    table[i][j] -= table[r][j] * table[i][s] * inv;
+            }
+        }
+        for (int j = 0; j < n + 2; ++j)
+        {
+            if (j != s)
+                table[r][j] *= inv;
+        }
+        for (int i = 0; i < m + 2; ++i)
+        {
+            if (i != r)
+                table[i][s] *= -inv;
+        }
+        table[r][s] = inv;
+        swap(basis[r], nonBasis[s]);
+    }
 
-    if (hasInconsistency(make_pair(eliminatedMatrix, rank)))
+    bool simplex(int phase)
     {
-        debug("Inconsistent system");
-        return 0;
+        const int objective = (phase == 1) ? m + 1 : m;
+        while (true)
+        {
+            int s = -1;
+            for (int j = 0; j <= n; ++j)
+            {
+                if (phase == 2 && nonBasis[j] == -1)
+                    continue;
+                if (s == -1 || table[objective][j] < table[objective][s] ||
+                    (table[objective][j] == table[objective][s] && nonBasis[j] < nonBasis[s]))
+                    s = j;
+            }
+            // No entering column (no variables left in phase 2) or none
+            // that improves the objective: optimal
+            if (s == -1 || table[objective][s] > -EPS)
+                return true;
+
+            int r = -1;
+            for (int i = 0; i < m; ++i)
+            {
+                if (table[i][s] < EPS)
+                    continue;
+                if (r == -1)
+                {
+                    r = i;
+                    continue;
+                }
+                const double lhs = table[i][n + 1] / table[i][s];
+                const double rhs = table[r][n + 1] / table[r][s];
+                if (lhs < rhs || (lhs == rhs && basis[i] < basis[r]))
+                    r = i;
+            }
+            if (r == -1)
+                return false;
+            pivot(r, s);
+        }
     }
+};
 
-    // Identify free variables and pivot columns
-    vector<bool> isBasic(numButtons, false);
-    vector<int> pivotCol(rank, -1);
+// Everything about a machine that depends only on its button wiring: the
+// eliminated system in terms of the free variables. Row i reads
+// pivot[i] * x[pivotCol[i]] + sum_j coef[i][j] * f_j = (T * t)[i], where f_j
+// is the value of button freeVars[j], t the joltage targets and pivot[i] > 0.
+struct MachineStructure
+{
+    int numJoltages = 0;
+    vector<uint64_t> buttons; // canonical order (sorted masks)
+    int rank = 0;
+    vector<int> pivotCol;
+    vector<int> freeVars;
+    vector<int128> pivot;
+    vector<vector<int128>> coef;
+    vector<vector<int128>> transform; // T, one row per counter
+};
+
+MachineStructure buildStructure(int numJoltages, const vector<uint64_t> &buttons)
+{
+    const int numButtons = buttons.size();
+    MachineStructure structure;
+    structure.numJoltages = numJoltages;
+    structure.buttons = buttons;
 
+    auto matrix = buildJoltageMatrix(numJoltages, buttons);
+    auto [eliminated, rank] = performGaussianElimination(matrix, numButtons);
+    structure.rank = rank;
+
+    vector<bool> isBasic(numButtons, false);
     for (int i = 0; i < rank; ++i)
     {
         for (int j = 0; j < numButtons; ++j)
         {
-            if (eliminatedMatrix[i][j] != 0)
+            if (eliminated[i][j] != 0)
             {
-                pivotCol[i] = j;
+                structure.pivotCol.push_back(j);
                 isBasic[j] = true;
                 break;
             }
         }
     }
 
-    vector<int> freeVars;
-    for (int i = 0; i < numButtons; ++i)
+    for (int j = 0; j < numButtons; ++j)
+    {
+        if (!isBasic[j])
+            structure.freeVars.push_back(j);
+    }
+
+    for (int i = 0; i < numJoltages; ++i)
+    {
+        const int128 sign = (i < rank && eliminated[i][structure.pivotCol[i]] < 0) ? -1 : 1;
+        if (i < rank)
+        {
+            structure.pivot.push_back(sign * eliminated[i][structure.pivotCol[i]]);
+            vector<int128> row;
+            for (int f : structure.freeVars)
+                row.push_back(sign * eliminated[i][f]);
+            structure.coef.push_back(row);
+        }
+
+        vector<int128> transformRow;
+        for (int j = 0; j < numJoltages; ++j)
+            transformRow.push_back(sign * eliminated[i][numButtons + j]);
+        structure.transform.push_back(transformRow);
+    }
+
+    return structure;
+}
+
+// A cached structure plus one set of joltage targets
+struct ReducedSystem
+{
+    const MachineStructure &structure;
+    vector<int128> rhs;      // (T * t) for the pivot rows
+    vector<long long> upper; // per button: presses can't exceed any counter it bumps
+};
+
+// Exact check of one free-variable assignment; returns the total presses
+// or -1 if some basic variable is fractional or out of bounds
+long long evaluateAssignment(const ReducedSystem &system, const vector<long long> &freeValues)
+{
+    long long total = accumulate(freeValues.begin(), freeValues.end(), 0LL);
+
+    for (size_t i = 0; i < system.structure.pivot.size(); ++i)
+    {
+        int128 value = system.rhs[i];
+        for (size_t j = 0; j < freeValues.size(); ++j)
+        {
+            if (!mulSubChecked<int128>(value, 1, system.structure.coef[i][j], freeValues[j], value))
+                throw runtime_error("Coefficient overflow during back-substitution");
+        }
+
+        if (value % system.structure.pivot[i] != 0)
+            return -1;
+        value /= system.structure.pivot[i];
+        if (value < 0 || value > system.upper[system.structure.pivotCol[i]])
+            return -1;
+        total += (long long)value;
+    }
+
+    return total;
+}
+
+// LP relaxation with every button bounded by lo[b] <= x[b] <= hi[b]. On
+// success returns the minimum total presses (a lower bound for the integer
+// problem) and the relaxed value of every button.
+//
+// The eliminated coefficients can exceed 2^53 on wide machines, so the
+// right-hand sides are formed exactly in __int128 and every constraint row
+// (and the objective) is scaled by its largest coefficient before it is
+// handed to the double-precision simplex, keeping its absolute EPS
+// meaningful.
+bool solveRelaxation(const ReducedSystem &system, const vector<long long> &lo, const vector<long long> &hi,
+                     double &bound, vector<double> &values)
+{
+    const int numFree = system.structure.freeVars.size();
+    const int rank = system.structure.pivot.size();
+    const auto &coef = system.structure.coef;
+    const auto &pivot = system.structure.pivot;
+
+    // Shift the free variables to g = f - lo >= 0. Row i's basic variable
+    // (rhs - coef.f) / pivot must lie in [lo, hi] of its button:
+    //    coef.g <= rhs - coef.lo - pivot * lo
+    //   -coef.g <= pivot * hi - rhs + coef.lo
+    vector<vector<double>> A;
+    vector<double> b;
+    vector<int128> shifted(rank);
+    long double constant = 0;
+    vector<long double> objective(numFree, 1.0L);
+
+    for (int j = 0; j < numFree; ++j)
+        constant += lo[system.structure.freeVars[j]];
+
+    for (int i = 0; i < rank; ++i)
     {
-        if (!isBasic[i])
-            freeVars.push_back(i);
+        const int basic = system.structure.pivotCol[i];
+        shifted[i] = system.rhs[i];
+        for (int j = 0; j < numFree; ++j)
+        {
+            if (!mulSubChecked<int128>(shifted[i], 1, coef[i][j], lo[system.structure.freeVars[j]], shifted[i]))
+                throw runtime_error("Coefficient overflow in LP relaxation");
+        }
+
+        int128 below, above;
+        if (!mulSubChecked<int128>(shifted[i], 1, pivot[i], lo[basic], below) ||
+            !mulSubChecked<int128>(pivot[i], hi[basic], shifted[i], 1, above))
+            throw runtime_error("Coefficient overflow in LP relaxation");
+
+        int128 scale = 0;
+        for (int j = 0; j < numFree; ++j)
+        {
+            scale = max(scale, coef[i][j] < 0 ? -coef[i][j] : coef[i][j]);
+            objective[j] -= (long double)coef[i][j] / (long double)pivot[i];
+        }
+        constant += (long double)shifted[i] / (long double)pivot[i];
+
+        // The basic variable is fixed by the box: check it exactly
+        if (scale == 0)
+        {
+            if (below < 0 || above < 0)
+                return false;
+            continue;
+        }
+
+        vector<double> row(numFree);
+        for (int j = 0; j < numFree; ++j)
+            row[j] = (double)((long double)coef[i][j] / (long double)scale);
+        A.push_back(row);
+        b.push_back((double)((long double)below / (long double)scale));
+        for (auto &v : row)
+            v = -v;
+        A.push_back(row);
+        b.push_back((double)((long double)above / (long double)scale));
+    }
+
+    for (int j = 0; j < numFree; ++j)
+    {
+        vector<double> row(numFree, 0.0);
+        row[j] = 1;
+        A.push_back(row);
+        b.push_back(hi[system.structure.freeVars[j]] - lo[system.structure.freeVars[j]]);
     }
 
-    debug("Rank:", rank, "Free vars:", (int)freeVars.size());
+    // Minimize constant + objective.g  <=>  maximize -objective.g / scale
+    long double objectiveScale = 0;
+    for (long double v : objective)
+        objectiveScale = max(objectiveScale, fabsl(v));
+    if (objectiveScale == 0)
+        objectiveScale = 1;
+    vector<double> c(numFree);
+    for (int j = 0; j < numFree; ++j)
+        c[j] = (double)(-objective[j] / objectiveScale);
+
+    double value;
+    vector<double> g;
+    LinearProgram lp(A, b, c);
+    if (!lp.solve(value, g))
+        return false;
 
-    // Helper function to check if a solution is valid and count presses
-    auto checkSolution = [&](const vector<long long> &freeVarValues) -> pair<bool, long long>
+    bound = (double)(constant - (long double)value * objectiveScale);
+    values.assign(lo.size(), 0.0);
+    for (int j = 0; j < numFree; ++j)
+        values[system.structure.freeVars[j]] = g[j] + lo[system.structure.freeVars[j]];
+    for (int i = 0; i < rank; ++i)
     {
-        vector<long long> solution(numButtons, 0);
-        for (size_t i = 0; i < freeVars.size(); ++i)
+        long double basicValue = (long double)shifted[i];
+        for (int j = 0; j < numFree; ++j)
+            basicValue -= (long double)coef[i][j] * g[j];
+        values[system.structure.pivotCol[i]] = (double)(basicValue / (long double)pivot[i]);
+    }
+    return true;
+}
+
+// Box of press counts still to be searched, lo[b] <= presses[b] <= hi[b]
+struct SearchBox
+{
+    vector<long long> lo, hi;
+};
+
+// Branch and bound on button press counts, pruned with LP relaxation
+// bounds. The incumbent is only ever updated from exact integer checks.
+// Every child box is strictly smaller, so the search terminates. Dives on
+// large targets can run thousands of boxes deep, so pending boxes live on
+// an explicit stack rather than the call stack.
+void branchAndBound(const ReducedSystem &system, const vector<long long> &lo, const vector<long long> &hi, long long &best)
+{
+    const double TOLERANCE = 1e-6;
+
+    vector<SearchBox> pending;
+    pending.push_back({lo, hi});
+    while (!pending.empty())
+    {
+        SearchBox box = move(pending.back());
+        pending.pop_back();
+
+        double bound;
+        vector<double> relaxed;
+        if (!solveRelaxation(system, box.lo, box.hi, bound, relaxed))
+            continue;
+
+        if ((long long)ceil(bound - TOLERANCE) >= best)
+            continue;
+
+        // Floating-point error can push a relaxed value just outside its box;
+        // clamped, a fractional value always lies strictly inside [lo, hi]
+        for (size_t b = 0; b < relaxed.size(); ++b)
+            relaxed[b] = min((double)box.hi[b], max((double)box.lo[b], relaxed[b]));
+
+        // Branch on the most fractional button
+        int branchVar = -1;
+        double branchFraction = TOLERANCE;
+        for (size_t b = 0; b < relaxed.size(); ++b)
         {
-            solution[freeVars[i]] = freeVarValues[i];
+            const double fraction = fabs(relaxed[b] - llround(relaxed[b]));
+            if (fraction > branchFraction)
+            {
+                branchFraction = fraction;
+                branchVar = b;
+            }
         }
 
-        // Back-substitute to find basic variable values
-        for (int i = rank - 1; i >= 0; --i)
+        // Children are pushed in reverse so the first one is searched next
+        auto pushChild = [&](int var, long long childLo, long long childHi)
+        {
+            SearchBox child = box;
+            child.lo[var] = childLo;
+            child.hi[var] = childHi;
+            pending.push_back(move(child));
+        };
+
+        if (branchVar == -1)
         {
-            int col = pivotCol[i];
-            if (col == -1)
+            // Integral relaxation: confirm the point exactly
+            vector<long long> point;
+            for (int f : system.structure.freeVars)
+                point.push_back(min(box.hi[f], max(box.lo[f], (long long)llround(relaxed[f]))));
+
+            const long long total = evaluateAssignment(system, point);
+            if (total >= 0)
+            {
+                // The LP optimum of this box is attained, nothing better inside
+                best = min(best, total);
                 continue;
+            }
 
-            long long rhs = eliminatedMatrix[i][numButtons];
-            for (int j = col + 1; j < numButtons; ++j)
+            // Rounding disagreed with exact arithmetic: split the box around
+            // the point on some free variable so every child is smaller. A
+            // fully fixed box that fails the check is simply infeasible.
+            for (size_t j = 0; j < point.size(); ++j)
             {
-                rhs -= eliminatedMatrix[i][j] * solution[j];
+                const int f = system.structure.freeVars[j];
+                if (box.lo[f] == box.hi[f])
+                    continue;
+
+                const long long v = point[j];
+                pushChild(f, v, v);
+                if (v < box.hi[f])
+                    pushChild(f, v + 1, box.hi[f]);
+                if (v > box.lo[f])
+                    pushChild(f, box.lo[f], v - 1);
+                break;
             }
+            continue;
+        }
 
-            if (eliminatedMatrix[i][col] == 0)
-                return {false, 0};
+        const long long down = (long long)floor(relaxed[branchVar]);
+        const long long boxLo = box.lo[branchVar], boxHi = box.hi[branchVar];
 
-            if (rhs % eliminatedMatrix[i][col] != 0)
-                return {false, 0};
+        // Both children must be strictly smaller boxes, or the search could
+        // revisit this box forever; otherwise fix the button to each value
+        if (down < boxLo || down >= boxHi)
+        {
+            for (long long v = boxHi; v >= boxLo; --v)
+                pushChild(branchVar, v, v);
+            continue;
+        }
 
-            long long val = rhs / eliminatedMatrix[i][col];
-            if (val < 0)
-                return {false, 0};
+        const bool downFirst = relaxed[branchVar] - down < 0.5;
+        if (downFirst)
+        {
+            pushChild(branchVar, down + 1, boxHi);
+            pushChild(branchVar, boxLo, down);
+        }
+        else
+        {
+            pushChild(branchVar, boxLo, down);
+            pushChild(branchVar, down + 1, boxHi);
+        }
+    }
+}
 
-            solution[col] = val;
+struct KeyHash
+{
+    size_t operator()(const vector<uint64_t> &key) const
+    {
+        uint64_t hash = 1469598103934665603ULL;
+        for (uint64_t value : key)
+        {
+            hash ^= value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
         }
+        return hash;
+    }
+};
 
-        long long totalPresses = accumulate(solution.begin(), solution.end(), 0LL);
-        return {true, totalPresses};
-    };
+// Two-level cache shared by all worker threads:
+// - button wiring -> eliminated structure, so a repeated wiring only
+//   re-solves its target column
+// - (wiring, targets) -> final answer, least recently used first out once
+//   MAX_CACHED_ANSWERS lines are held
+class SolveCache
+{
+public:
+    shared_ptr<const MachineStructure> findStructure(const vector<uint64_t> &key)
+    {
+        lock_guard<mutex> guard(lock);
+        auto it = structures.find(key);
+        if (it == structures.end())
+        {
+            ++structureMisses;
+            return nullptr;
+        }
+        ++structureHits;
+        return it->second;
+    }
 
-    // If no free variables, there's a unique solution
-    if (freeVars.empty())
+    shared_ptr<const MachineStructure> storeStructure(const vector<uint64_t> &key, MachineStructure structure)
     {
-        auto [valid, presses] = checkSolution({});
-        return valid ? presses : 0;
+        lock_guard<mutex> guard(lock);
+        // Another thread may have built the same structure meanwhile
+        auto [it, inserted] = structures.emplace(key, make_shared<const MachineStructure>(move(structure)));
+        return it->second;
     }
 
-    // For free variables, use recursive branch-and-bound with greedy optimization
-    long long minPresses = LLONG_MAX;
-    bool foundSolution = false;
+    bool findAnswer(const vector<uint64_t> &key, long long &answer)
+    {
+        lock_guard<mutex> guard(lock);
+        auto it = answers.find(key);
+        if (it == answers.end())
+        {
+            ++answerMisses;
+            return false;
+        }
+        ++answerHits;
+        recentAnswers.splice(recentAnswers.begin(), recentAnswers, it->second.recency);
+        answer = it->second.answer;
+        return true;
+    }
 
-    // Compute upper bounds for each free variable based on minimum target joltage
-    long long maxTarget = 0;
-    for (int j : machine.joltage)
+    void storeAnswer(const vector<uint64_t> &key, long long answer)
     {
-        maxTarget = max(maxTarget, (long long)j);
+        lock_guard<mutex> guard(lock);
+        if (answers.count(key))
+            return; // another thread solved the same line meanwhile
+
+        if (answers.size() >= MAX_CACHED_ANSWERS)
+        {
+            answers.erase(*recentAnswers.back());
+            recentAnswers.pop_back();
+            ++answerEvictions;
+        }
+        auto it = answers.emplace(key, CachedAnswer{answer, {}}).first;
+        recentAnswers.push_front(&it->first);
+        it->second.recency = recentAnswers.begin();
     }
-    const long long maxFreeVarValue = maxTarget + 100;
 
-    // Recursive branch-and-bound search with pruning
-    function<void(int, vector<long long> &, long long)> search =
-        [&](int freeVarIdx, vector<long long> &freeVarValues, long long currentSum)
+    void report() const
     {
-        // Prune: if current sum already exceeds best, stop
-        if (currentSum >= minPresses)
-            return;
+        auto rate = [](size_t hits, size_t misses)
+        { return hits + misses == 0 ? 0.0 : 100.0 * hits / (hits + misses); };
+
+        print("Answer cache:", answerHits, "hits,", answerMisses, "misses,", rate(answerHits, answerMisses), "% hit rate,", answerEvictions, "evictions");
+        print("Structure cache:", structureHits, "hits,", structureMisses, "misses,", rate(structureHits, structureMisses), "% hit rate");
+    }
+
+private:
+    static constexpr size_t MAX_CACHED_ANSWERS = size_t(1) << 18;
+
+    struct CachedAnswer
+    {
+        long long answer;
+        list<const vector<uint64_t> *>::iterator recency;
+    };
+
+    mutex lock;
+    unordered_map<vector<uint64_t>, shared_ptr<const MachineStructure>, KeyHash> structures;
+    unordered_map<vector<uint64_t>, CachedAnswer, KeyHash> answers;
+    list<const vector<uint64_t> *> recentAnswers; // keys owned by answers, most recent first
+    size_t structureHits = 0, structureMisses = 0;
+    size_t answerHits = 0, answerMisses = 0, answerEvictions = 0;
+};
+
+// Core solver - find minimum nonnegative integer solution
+long long findMinPresses(const Machine &machine, SolveCache &cache)
+{
+    const int numJoltages = machine.numJoltages;
+
+    // Canonical wiring: only bits for existing counters, buttons sorted.
+    // Button order does not change the minimum number of presses.
+    const uint64_t counterBits = numJoltages >= 64 ? ~uint64_t(0) : (uint64_t(1) << numJoltages) - 1;
+    vector<uint64_t> buttons;
+    for (int b = 0; b < machine.numButtons; ++b)
+        buttons.push_back(machine.buttons[b] & counterBits);
+    sort(buttons.begin(), buttons.end());
 
-        // Base case: all free variables assigned
-        if (freeVarIdx == (int)freeVars.size())
+    vector<uint64_t> structureKey = {(uint64_t)numJoltages};
+    structureKey.insert(structureKey.end(), buttons.begin(), buttons.end());
+
+    vector<uint64_t> answerKey = structureKey;
+    answerKey.insert(answerKey.end(), machine.joltage, machine.joltage + numJoltages);
+
+    long long answer;
+    if (cache.findAnswer(answerKey, answer))
+        return answer;
+
+    auto structure = cache.findStructure(structureKey);
+    if (!structure)
+        structure = cache.storeStructure(structureKey, buildStructure(numJoltages, buttons));
+
+    // Reduce the target column with the recorded row operations
+    vector<int128> reducedTarget(numJoltages, 0);
+    for (int i = 0; i < numJoltages; ++i)
+    {
+        for (int j = 0; j < numJoltages; ++j)
+        {
+            if (!mulSubChecked<int128>(reducedTarget[i], 1, structure->transform[i][j], -(int128)machine.joltage[j], reducedTarget[i]))
+                throw runtime_error("Coefficient overflow while reducing targets");
+        }
+    }
+
+    answer = 0;
+    if (!hasInconsistency(reducedTarget, structure->rank))
+    {
+        ReducedSystem system{*structure, vector<int128>(reducedTarget.begin(), reducedTarget.begin() + structure->rank), {}};
+
+        // Tight per-button bounds from the joltage targets
+        system.upper.assign(buttons.size(), LLONG_MAX);
+        for (size_t b = 0; b < buttons.size(); ++b)
         {
-            auto [valid, presses] = checkSolution(freeVarValues);
-            if (valid)
+            for (int j = 0; j < numJoltages; ++j)
             {
-                minPresses = min(minPresses, presses);
-                foundSolution = true;
+                if ((buttons[b] >> j) & 1)
+                    system.upper[b] = min(system.upper[b], (long long)machine.joltage[j]);
             }
+            // A button that bumps no counter is never worth pressing
+            if (system.upper[b] == LLONG_MAX)
+                system.upper[b] = 0;
+        }
+
+        long long best = LLONG_MAX;
+        if (structure->freeVars.empty())
+        {
+            // Unique solution: no search needed
+            const long long total = evaluateAssignment(system, {});
+            if (total >= 0)
+                best = total;
+        }
+        else
+        {
+            vector<long long> lo(buttons.size(), 0);
+            vector<long long> hi = system.upper;
+            branchAndBound(system, lo, hi, best);
+        }
+        answer = (best == LLONG_MAX) ? 0 : best;
+    }
+
+    cache.storeAnswer(answerKey, answer);
+    return answer;
+}
+
+// Exhaustive search over press counts, for cross-checking on small machines
+long long bruteForceMinPresses(const Machine &machine)
+{
+    vector<long long> remaining(machine.joltage, machine.joltage + machine.numJoltages);
+    long long best = LLONG_MAX;
+
+    function<void(int, long long)> search = [&](int b, long long presses)
+    {
+        if (presses >= best)
+            return;
+        if (b == machine.numButtons)
+        {
+            if (all_of(remaining.begin(), remaining.end(), [](long long r)
+                       { return r == 0; }))
+                best = presses;
             return;
         }
 
-        // Try values for this free variable, starting from 0
-        // Limit search to avoid explosion; adaptive based on remaining budget
-        long long remainingBudget = max(100LL, minPresses - currentSum);
-        for (long long val = 0; val <= min(maxFreeVarValue, remainingBudget); ++val)
+        long long limit = LLONG_MAX;
+        for (int j = 0; j < machine.numJoltages; ++j)
+        {
+            if ((machine.buttons[b] >> j) & 1)
+                limit = min(limit, remaining[j]);
+        }
+        if (limit == LLONG_MAX)
+            limit = 0;
+
+        for (long long k = 0; k <= limit; ++k)
+        {
+            for (int j = 0; j < machine.numJoltages; ++j)
+            {
+                if ((machine.buttons[b] >> j) & 1)
+                    remaining[j] -= k;
+            }
+            search(b + 1, presses + k);
+            for (int j = 0; j < machine.numJoltages; ++j)
+            {
+                if ((machine.buttons[b] >> j) & 1)
+                    remaining[j] += k;
+            }
+        }
+    };
+
+    search(0, 0);
+    return best == LLONG_MAX ? 0 : best;
+}
+
+// Build a machine line with random buttons over numJoltages counters. Buttons
+// that came out empty bump counter 0 instead so every button does something.
+string randomMachineLine(mt19937 &rng, int numJoltages, int numButtons, vector<uint64_t> &masks)
+{
+    masks.assign(numButtons, 0);
+    string line = "[.]";
+    for (auto &mask : masks)
+    {
+        string button;
+        for (int j = 0; j < numJoltages; ++j)
+        {
+            if (rng() % 2 == 0)
+            {
+                mask |= uint64_t(1) << j;
+                button += (button.empty() ? "" : ",") + to_string(j);
+            }
+        }
+        line += " (" + (button.empty() ? "0" : button) + ")";
+        if (button.empty())
+            mask = 1;
+    }
+    return line;
+}
+
+string joltageSuffix(const vector<long long> &targets)
+{
+    string suffix = " {";
+    for (size_t j = 0; j < targets.size(); ++j)
+        suffix += (j ? "," : "") + to_string(targets[j]);
+    return suffix + "}";
+}
+
+// Compare findMinPresses with brute force on random small machines. Most
+// targets are built from random presses so a solution exists; the rest are
+// random and often unreachable. Returns the number of mismatches.
+int crossCheckBranchAndBound(int numMachines, unsigned seed)
+{
+    mt19937 rng(seed);
+    MachineArena arena;
+
+    for (int m = 0; m < numMachines; ++m)
+    {
+        const int numJoltages = 1 + rng() % 5;
+        const int numButtons = 1 + rng() % 6;
+
+        vector<uint64_t> masks;
+        string line = randomMachineLine(rng, numJoltages, numButtons, masks);
+
+        vector<long long> targets(numJoltages, 0);
+        if (rng() % 4 != 0)
+        {
+            for (uint64_t mask : masks)
+            {
+                const int presses = rng() % 6;
+                for (int j = 0; j < numJoltages; ++j)
+                {
+                    if ((mask >> j) & 1)
+                        targets[j] += presses;
+                }
+            }
+        }
+        else
+        {
+            for (long long &target : targets)
+                target = rng() % 10;
+        }
+
+        arena.parseLine(line + joltageSuffix(targets));
+    }
+
+    SolveCache cache;
+    int mismatches = 0;
+    for (size_t m = 0; m < arena.size(); ++m)
+    {
+        const long long expected = bruteForceMinPresses(arena[m]);
+        const long long actual = findMinPresses(arena[m], cache);
+        if (expected != actual)
         {
-            freeVarValues[freeVarIdx] = val;
-            search(freeVarIdx + 1, freeVarValues, currentSum + val);
+            print("MISMATCH on random machine", (int)m, "- expected", expected, "got", actual);
+            ++mismatches;
         }
+    }
+
+    return mismatches;
+}
+
+// Machines that once broke the search, with their brute-force answers.
+// The first dives thousands of boxes deep before the bound closes.
+int checkKnownMachines()
+{
+    const vector<pair<string, long long>> known = {
+        {"[....] (0,1,2) (0,3) (0,1) (0,2,3) (1,3) (0) {4038,2915,1629,2994}", 4974},
     };
 
-    vector<long long> freeVarValues(freeVars.size(), 0);
-    search(0, freeVarValues, 0);
+    MachineArena arena;
+    for (const auto &[line, expected] : known)
+        arena.parseLine(line);
+
+    SolveCache cache;
+    int failures = 0;
+    for (size_t m = 0; m < known.size(); ++m)
+    {
+        const long long actual = findMinPresses(arena[m], cache);
+        if (actual != known[m].second)
+        {
+            print("FAILURE on known machine", (int)m, "- expected", known[m].second, "got", actual);
+            ++failures;
+        }
+    }
 
-    return foundSolution ? minPresses : 0;
+    return failures;
+}
+
+// Regression for wide machines (25 counters, 28 buttons) whose Bareiss
+// coefficients run into the thousands. Brute force is out of reach, so each
+// answer is checked against the planted press count from above and the
+// largest target from below. Returns the number of failures.
+int checkWideMachines(int numMachines, unsigned seed)
+{
+    const int numJoltages = 25;
+    const int numButtons = 28;
+    mt19937 rng(seed);
+    SolveCache cache;
+    int failures = 0;
+
+    for (int m = 0; m < numMachines; ++m)
+    {
+        vector<uint64_t> masks;
+        string line = randomMachineLine(rng, numJoltages, numButtons, masks);
+
+        vector<long long> targets(numJoltages, 0);
+        long long planted = 0;
+        for (uint64_t mask : masks)
+        {
+            const int presses = rng() % 100;
+            planted += presses;
+            for (int j = 0; j < numJoltages; ++j)
+            {
+                if ((mask >> j) & 1)
+                    targets[j] += presses;
+            }
+        }
+
+        MachineArena arena;
+        arena.parseLine(line + joltageSuffix(targets));
+        const long long actual = findMinPresses(arena[0], cache);
+        const long long lowest = *max_element(targets.begin(), targets.end());
+        if (actual < lowest || actual > planted)
+        {
+            print("FAILURE on wide machine", m, "- got", actual, "expected between", lowest, "and", planted);
+            ++failures;
+        }
+    }
+
+    return failures;
 }
 
 int main(int argc, char *argv[])
 {
+    // Check mode: a longer brute-force comparison plus the regression machines
+    if (argc > 1 && string(argv[1]) == "check")
+    {
+        const int mismatches = crossCheckBranchAndBound(5000, 11);
+        const int failures = checkKnownMachines() + checkWideMachines(6, 5);
+        print("Random machines mismatched:", mismatches);
+        print("Regression machines failed:", failures);
+        return (mismatches == 0 && failures == 0) ? 0 : 1;
+    }
+
     const string folder = (argc > 2) ? argv[2] : ".";
     const string filename = (argc > 1 && string(argv[1]) == "i") ? "input.txt" : "example.txt";
     const string inputFilePath = folder + "/" + filename;
@@ -367,21 +1136,25 @@ int main(int argc, char *argv[])
 
     debug("Lines:", (int)lines.size());
 
-    int idx = 0;
-    long long totalMinPresses = accumulate(
-        lines.begin(),
-        lines.end(),
-        0LL,
-        [&idx](long long total, const string &line) mutable
-        {
-            ++idx;
-            const auto machine = parseLine(line);
-            const long long presses = findMinPresses(machine);
-            debug("Machine", idx, "- Min presses:", presses);
-            return total + presses;
-        });
+    MachineArena arena;
+    for (const auto &line : lines)
+        arena.parseLine(line);
+
+    // Solve machines on the work-stealing pool, then reduce in input order
+    SolveCache cache;
+    vector<long long> presses(arena.size());
+    parallelForStealing(arena.size(), [&](size_t idx)
+                        { presses[idx] = findMinPresses(arena[idx], cache); });
+
+    long long totalMinPresses = 0;
+    for (size_t idx = 0; idx < presses.size(); ++idx)
+    {
+        debug("Machine", (int)idx + 1, "- Min presses:", presses[idx]);
+        totalMinPresses += presses[idx];
+    }
 
     print("Total minimum presses:", totalMinPresses);
+    cache.report();
 
     return 0;
 }
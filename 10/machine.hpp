@@ -0,0 +1,183 @@
+/**
+ * Shared machine-manual parser for Day 10 and Day 10-2.
+ *
+ * A manual line looks like:
+ *
+ *     [.##.] (3) (1,3) (2) (2,3) (0,2) (0,1) {3,5,4,7}
+ *
+ * The line is scanned once, left to right, without regexes or temporary
+ * strings. Machines are stored flat in a MachineArena: every button is a
+ * single bit mask (bit i = the button touches light/counter i) and all
+ * button masks and joltage values live in two contiguous arrays. A Machine
+ * is a lightweight view into the arena.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Lights / counters per machine are limited by the width of a button mask
+constexpr int MAX_MACHINE_LIGHTS = 64;
+
+struct Machine
+{
+    int numLights = 0;
+    uint64_t target = 0;               // bit i set = light i must end up on
+    const uint64_t *buttons = nullptr; // one mask per button
+    int numButtons = 0;
+    const int *joltage = nullptr;      // one requirement per counter
+    int numJoltages = 0;
+};
+
+class MachineArena
+{
+public:
+    // Parse one manual line and append it; blank lines are skipped.
+    // Returns true if a machine was added.
+    bool parseLine(const char *begin, const char *end)
+    {
+        Record record;
+        record.buttonOffset = buttonMasks.size();
+        record.joltageOffset = joltages.size();
+
+        const char *p = begin;
+        bool seenAnything = false;
+
+        while (p < end)
+        {
+            const char c = *p;
+            if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+            {
+                ++p;
+                continue;
+            }
+
+            seenAnything = true;
+
+            if (c == '[')
+            {
+                ++p;
+                while (p < end && (*p == '.' || *p == '#'))
+                {
+                    if (record.numLights == MAX_MACHINE_LIGHTS)
+                        fail("too many lights", begin, end);
+                    if (*p == '#')
+                        record.target |= uint64_t(1) << record.numLights;
+                    ++record.numLights;
+                    ++p;
+                }
+                expect(p, end, ']', begin);
+            }
+            else if (c == '(')
+            {
+                ++p;
+                uint64_t mask = 0;
+                parseNumberList(p, end, ')', begin, [&](long long idx)
+                                {
+                    if (idx >= MAX_MACHINE_LIGHTS)
+                        fail("button index out of range", begin, end);
+                    mask |= uint64_t(1) << idx; });
+                buttonMasks.push_back(mask);
+                ++record.numButtons;
+            }
+            else if (c == '{')
+            {
+                ++p;
+                parseNumberList(p, end, '}', begin, [&](long long value)
+                                {
+                    joltages.push_back(static_cast<int>(value));
+                    ++record.numJoltages; });
+            }
+            else
+            {
+                fail("unexpected character", begin, end);
+            }
+        }
+
+        if (!seenAnything)
+            return false;
+
+        records.push_back(record);
+        return true;
+    }
+
+    bool parseLine(const std::string &line)
+    {
+        return parseLine(line.data(), line.data() + line.size());
+    }
+
+    size_t size() const { return records.size(); }
+
+    // Views stay valid until the next parseLine call
+    Machine operator[](size_t idx) const
+    {
+        const Record &record = records[idx];
+        Machine machine;
+        machine.numLights = record.numLights;
+        machine.target = record.target;
+        machine.buttons = buttonMasks.data() + record.buttonOffset;
+        machine.numButtons = record.numButtons;
+        machine.joltage = joltages.data() + record.joltageOffset;
+        machine.numJoltages = record.numJoltages;
+        return machine;
+    }
+
+private:
+    struct Record
+    {
+        int numLights = 0;
+        uint64_t target = 0;
+        uint32_t buttonOffset = 0;
+        int numButtons = 0;
+        uint32_t joltageOffset = 0;
+        int numJoltages = 0;
+    };
+
+    std::vector<uint64_t> buttonMasks;
+    std::vector<int> joltages;
+    std::vector<Record> records;
+
+    [[noreturn]] static void fail(const char *what, const char *begin, const char *end)
+    {
+        throw std::runtime_error(std::string("Invalid machine line (") + what + "): " + std::string(begin, end));
+    }
+
+    static void expect(const char *&p, const char *end, char closing, const char *begin)
+    {
+        if (p == end || *p != closing)
+            fail("unterminated group", begin, end);
+        ++p;
+    }
+
+    // Comma-separated non-negative integers up to the closing character
+    template <typename OnNumber>
+    static void parseNumberList(const char *&p, const char *end, char closing, const char *begin, OnNumber onNumber)
+    {
+        while (true)
+        {
+            if (p == end || *p < '0' || *p > '9')
+                fail("expected a number", begin, end);
+
+            long long value = 0;
+            while (p < end && *p >= '0' && *p <= '9')
+            {
+                value = value * 10 + (*p - '0');
+                if (value > 1000000000)
+                    fail("number too large", begin, end);
+                ++p;
+            }
+            onNumber(value);
+
+            if (p < end && *p == ',')
+            {
+                ++p;
+                continue;
+            }
+            expect(p, end, closing, begin);
+            return;
+        }
+    }
+};
@@ -14,9 +14,12 @@
  * We treat this as a math problem (like solving equations):
  * 1. Create a matrix (table) where each button is a column and each light is a row
  * 2. Mark which lights each button affects with 1s and 0s
- * 3. Use Gaussian elimination (a standard math technique) to simplify the problem
+ * 3. Use Gaussian elimination (a standard math technique) to simplify the problem,
+ *    with each row packed into 64-bit words so a row operation is a few XORs
  * 4. If there's no solution, return 0
  * 5. If there are multiple solutions, test each one and pick the one with fewest button presses
+ *    (walking them in Gray-code order so each step only toggles one free variable,
+ *    or meeting in the middle over two halves of the free variables when there are many)
  *
  * The key insight: We work in binary (on/off) world where pressing a button twice = not pressing it
  */
@@ -26,11 +29,19 @@
 #include <sstream>
 #include <vector>
 #include <string>
-#include <regex>
+#include <chrono>
 #include <algorithm>
 #include <limits>
 #include <numeric>
 #include <functional>
+#include <array>
+#include <cstdint>
+#include <random>
+#include <unordered_map>
+
+#include "machine.hpp"
+#include "work_stealing.hpp"
+#include "../01/bench_timing.hpp"
 
 using namespace std;
 
@@ -73,287 +84,406 @@ vector<string> readLines(const string &filename)
 // Problem-specific code
 // ==================================
 
-// Parsing helpers
-auto extractTargetDiagram = [](const string &line) -> vector<bool>
+// Packed GF(2) augmented matrix: one row per light, one bit per button and
+// the target bit in column numButtons. Rows are `Words` 64-bit words wide so
+// row operations are a handful of word XORs.
+template <size_t Words>
+struct BitMatrix
 {
-    regex targetRegex(R"(\[([.#]+)\])");
-    smatch targetMatch;
-    if (regex_search(line, targetMatch, targetRegex))
+    using Row = array<uint64_t, Words>;
+
+    vector<Row> rows;
+    int numButtons = 0;
+
+    static bool test(const Row &row, int col)
     {
-        const string &diagram = targetMatch[1].str();
-        vector<bool> result;
-        result.reserve(diagram.size());
-        transform(diagram.begin(), diagram.end(), back_inserter(result),
-                  [](char c)
-                  { return c == '#'; });
-        return result;
+        return (row[col / 64] >> (col % 64)) & 1;
     }
-    return {};
-};
 
-auto extractButtons = [](const string &line) -> vector<vector<int>>
-{
-    regex buttonRegex(R"(\(([0-9,]+)\))");
-    smatch buttonMatch;
-    vector<vector<int>> buttons;
-    string::const_iterator searchStart(line.cbegin());
+    static void set(Row &row, int col)
+    {
+        row[col / 64] |= uint64_t(1) << (col % 64);
+    }
 
-    while (regex_search(searchStart, line.cend(), buttonMatch, buttonRegex))
+    static void xorInto(Row &dst, const Row &src)
     {
-        vector<int> button;
-        stringstream ss(buttonMatch[1].str());
-        string num;
-        while (getline(ss, num, ','))
+        for (size_t w = 0; w < Words; ++w)
+            dst[w] ^= src[w];
+    }
+
+    // Lowest set column, or -1 for an all-zero row
+    static int lowestBit(const Row &row)
+    {
+        for (size_t w = 0; w < Words; ++w)
         {
-            button.push_back(stoi(num));
+            if (row[w] != 0)
+                return w * 64 + __builtin_ctzll(row[w]);
         }
-        buttons.push_back(move(button));
-        searchStart = buttonMatch.suffix().first;
+        return -1;
     }
-    return buttons;
-};
 
-struct Machine
-{
-    vector<bool> target;
-    vector<vector<int>> buttons;
+    static int popcount(const Row &row)
+    {
+        int bits = 0;
+        for (size_t w = 0; w < Words; ++w)
+            bits += __builtin_popcountll(row[w]);
+        return bits;
+    }
 };
 
-Machine parseLine(const string &line)
-{
-    return Machine{
-        extractTargetDiagram(line),
-        extractButtons(line)};
-}
-
-// Matrix builder
-auto buildMatrix = [](const Machine &machine)
+template <size_t Words>
+BitMatrix<Words> buildMatrix(const Machine &machine)
 {
-    const int numLights = machine.target.size();
-    const int numButtons = machine.buttons.size();
+    BitMatrix<Words> matrix;
+    matrix.numButtons = machine.numButtons;
+    matrix.rows.assign(machine.numLights, {});
 
-    vector<vector<int>> matrix(numLights, vector<int>(numButtons + 1, 0));
-
-    // Populate matrix from buttons
-    for (int b = 0; b < numButtons; ++b)
+    for (int i = 0; i < machine.numLights; ++i)
     {
-        for (int lightIdx : machine.buttons[b])
+        for (int b = 0; b < machine.numButtons; ++b)
         {
-            matrix[lightIdx][b] = 1;
+            if ((machine.buttons[b] >> i) & 1)
+                BitMatrix<Words>::set(matrix.rows[i], b);
         }
-    }
 
-    // Add target as augmented column
-    for (int i = 0; i < numLights; ++i)
-    {
-        matrix[i][numButtons] = machine.target[i] ? 1 : 0;
+        if ((machine.target >> i) & 1)
+            BitMatrix<Words>::set(matrix.rows[i], matrix.numButtons);
     }
 
     return matrix;
-};
+}
 
-// Gaussian elimination (GF(2))
-auto performGaussianElimination = [](vector<vector<int>> matrix)
+// Gauss-Jordan elimination to reduced row echelon form; returns the rank.
+// Afterwards row i < rank has its pivot at its lowest set bit.
+template <size_t Words>
+int performGaussianElimination(BitMatrix<Words> &matrix)
 {
-    const int numLights = matrix.size();
-    const int numButtons = matrix[0].size() - 1;
-
+    const int numRows = matrix.rows.size();
     int rank = 0;
-    vector<int> pivotCol(numLights, -1);
 
-    for (int col = 0; col < numButtons && rank < numLights; ++col)
+    for (int col = 0; col < matrix.numButtons && rank < numRows; ++col)
     {
-        // Find pivot
-        auto pivotIt = find_if(matrix.begin() + rank, matrix.end(),
-                               [col](const vector<int> &row)
-                               { return row[col] == 1; });
+        int pivotRow = rank;
+        while (pivotRow < numRows && !BitMatrix<Words>::test(matrix.rows[pivotRow], col))
+            ++pivotRow;
 
-        if (pivotIt == matrix.end())
+        if (pivotRow == numRows)
             continue;
 
-        int pivotRow = distance(matrix.begin(), pivotIt);
-        swap(matrix[rank], matrix[pivotRow]);
-        pivotCol[rank] = col;
-
-        // Row elimination
-        for_each(matrix.begin(), matrix.end(),
-                 [rank, col, &matrix, numButtons](vector<int> &row)
-                 {
-                     if (&row != &matrix[rank] && row[col] == 1)
-                     {
-                         for (int j = 0; j <= numButtons; ++j)
-                         {
-                             row[j] ^= matrix[rank][j];
-                         }
-                     }
-                 });
+        swap(matrix.rows[rank], matrix.rows[pivotRow]);
+
+        for (int i = 0; i < numRows; ++i)
+        {
+            if (i != rank && BitMatrix<Words>::test(matrix.rows[i], col))
+                BitMatrix<Words>::xorInto(matrix.rows[i], matrix.rows[rank]);
+        }
 
         rank++;
     }
 
-    return make_pair(matrix, rank);
-};
-
-// Check inconsistency in augmented matrix
-auto hasInconistency = [](const pair<vector<vector<int>>, int> &state)
-{
-    const auto &matrix = state.first;
-    const int rank = state.second;
-    const int numButtons = matrix[0].size() - 1;
-
-    return any_of(matrix.begin() + rank, matrix.end(),
-                  [numButtons](const vector<int> &row)
-                  {
-                      return row[numButtons] == 1;
-                  });
-};
+    return rank;
+}
 
-// Identify free variables (non-pivot columns)
-auto getFreeVariables = [](const pair<vector<vector<int>>, int> &state)
+// Best free-variable weight for every reachable basic-variable pattern when
+// only the given null-space vectors may be toggled (Gray-code walk)
+unordered_map<uint64_t, int> enumerateHalf(const vector<uint64_t> &basicParts)
 {
-    const auto &pivotCols = state.first;
-    const int rank = state.second;
-    const int numButtons = pivotCols[0].size() - 1;
+    unordered_map<uint64_t, int> best;
+    uint64_t basics = 0;
+    best[basics] = 0;
 
-    vector<bool> isBasic(numButtons, false);
-    for (int i = 0; i < rank; ++i)
+    for (uint64_t code = 1; code < (uint64_t(1) << basicParts.size()); ++code)
     {
-        // This is a simplified approach - in practice we'd track pivotCol separately
-        for (int j = 0; j < numButtons; ++j)
-        {
-            if (pivotCols[i][j] == 1)
-                isBasic[j] = true;
-        }
+        basics ^= basicParts[__builtin_ctzll(code)];
+        const int weight = __builtin_popcountll(code ^ (code >> 1));
+        auto [it, inserted] = best.emplace(basics, weight);
+        if (!inserted && weight < it->second)
+            it->second = weight;
     }
 
-    vector<int> freeVars;
-    for (int i = 0; i < numButtons; ++i)
-    {
-        if (!isBasic[i])
-            freeVars.push_back(i);
-    }
-    return freeVars;
-};
+    return best;
+}
 
-// Evaluate a solution given a free-variable mask
-auto evaluateSolution = [](const vector<vector<int>> &matrix,
-                           const vector<int> &freeVars,
-                           const int rank,
-                           int mask)
+// Minimum Hamming weight over the solution set without enumerating all 2^k
+// free-variable assignments. Basic variables are bits of a mask indexed by
+// pivot row; basicParts[f] is the set of basic variables flipped by free
+// variable f. The free variables are split in two halves and each half is
+// enumerated into a table keyed by the basic pattern it produces.
+//
+// The tables are joined by hashing: final basic patterns y are tried in
+// order of increasing popcount, looking up the right half that completes
+// each left half, until the popcount alone cannot beat the best total. If
+// that would cost more than comparing every left/right pair, the pairwise
+// join is used instead. Both are exact.
+int minWeightMeetInTheMiddle(uint64_t particular, const vector<uint64_t> &basicParts, int rank)
 {
-    const int numButtons = matrix[0].size() - 1;
-    vector<int> solution(numButtons, 0);
+    const size_t half = basicParts.size() / 2;
+    auto left = enumerateHalf(vector<uint64_t>(basicParts.begin(), basicParts.begin() + half));
+    auto right = enumerateHalf(vector<uint64_t>(basicParts.begin() + half, basicParts.end()));
 
-    // Set free variables based on mask
-    for (int i = 0; i < freeVars.size(); ++i)
-    {
-        solution[freeVars[i]] = (mask >> i) & 1;
-    }
+    if (left.size() > right.size())
+        swap(left, right);
+
+    const double pairwiseCost = double(left.size()) * right.size();
+    double hashCost = 0;
+    double patternsWithBits = 1; // C(rank, bits)
+    int best = numeric_limits<int>::max();
 
-    // Back-substitution
-    for (int i = rank - 1; i >= 0; --i)
+    for (int bits = 0; bits <= rank && bits < best; ++bits)
     {
-        int col = -1;
-        for (int j = 0; j < numButtons; ++j)
+        hashCost += patternsWithBits * left.size();
+        patternsWithBits = patternsWithBits * (rank - bits) / (bits + 1);
+
+        if (hashCost > pairwiseCost)
         {
-            if (matrix[i][j] == 1)
+            for (const auto &[leftBasics, leftWeight] : left)
             {
-                col = j;
-                break;
+                for (const auto &[rightBasics, rightWeight] : right)
+                {
+                    const int weight = leftWeight + rightWeight +
+                                       __builtin_popcountll(particular ^ leftBasics ^ rightBasics);
+                    best = min(best, weight);
+                }
             }
+            return best;
         }
 
-        if (col == -1)
-            continue;
-
-        int val = matrix[i][numButtons];
-        for (int j = col + 1; j < numButtons; ++j)
+        // Gosper's hack over all rank-bit masks with `bits` bits set
+        uint64_t y = (bits == 64) ? ~uint64_t(0) : (uint64_t(1) << bits) - 1;
+        while (true)
         {
-            val ^= (matrix[i][j] & solution[j]);
+            for (const auto &[leftBasics, leftWeight] : left)
+            {
+                auto it = right.find(particular ^ leftBasics ^ y);
+                if (it != right.end())
+                    best = min(best, bits + leftWeight + it->second);
+            }
+
+            if (bits == 0)
+                break;
+
+            const uint64_t lowest = y & (~y + 1);
+            const uint64_t ripple = y + lowest;
+            if (ripple == 0)
+                break;
+            y = (((ripple ^ y) >> 2) / lowest) | ripple;
+            if (rank < 64 && y >= (uint64_t(1) << rank))
+                break;
         }
-        solution[col] = val;
     }
 
-    // Count presses using std::accumulate
-    return accumulate(solution.begin(), solution.end(), 0);
-};
+    return best;
+}
 
-// Core solver
-int findMinPresses(const Machine &machine)
+enum class SolverMode
 {
-    const int numLights = machine.target.size();
-    const int numButtons = machine.buttons.size();
+    Auto,
+    GrayCode,
+    MeetInTheMiddle
+};
 
-    auto matrix = buildMatrix(machine);
-    auto [eliminatedMatrix, rank] = performGaussianElimination(matrix);
+// Largest nullity enumerated exhaustively (2^n XOR + popcount steps)
+constexpr int MAX_GRAY_CODE_FREE_VARS = 30;
 
-    if (hasInconistency(make_pair(eliminatedMatrix, rank)))
-        return 0;
+// Core solver for a fixed row width
+template <size_t Words>
+int findMinPressesPacked(const Machine &machine, SolverMode mode)
+{
+    using Matrix = BitMatrix<Words>;
 
-    // Identify free variables and compute pivot columns
-    vector<bool> isBasic(numButtons, false);
-    vector<int> pivotCol(numLights, -1);
+    auto matrix = buildMatrix<Words>(machine);
+    const int rank = performGaussianElimination(matrix);
+    const int numButtons = matrix.numButtons;
 
+    // A zero row with the target bit set means no solution
+    for (size_t i = rank; i < matrix.rows.size(); ++i)
+    {
+        if (Matrix::test(matrix.rows[i], numButtons))
+            return 0;
+    }
+
+    vector<int> pivotCol(rank);
+    typename Matrix::Row isBasic{};
     for (int i = 0; i < rank; ++i)
     {
-        for (int j = 0; j < numButtons; ++j)
-        {
-            if (eliminatedMatrix[i][j] == 1)
-            {
-                pivotCol[i] = j;
-                isBasic[j] = true;
-                break;
-            }
-        }
+        pivotCol[i] = Matrix::lowestBit(matrix.rows[i]);
+        Matrix::set(isBasic, pivotCol[i]);
     }
 
     vector<int> freeVars;
     for (int i = 0; i < numButtons; ++i)
     {
-        if (!isBasic[i])
+        if (!Matrix::test(isBasic, i))
             freeVars.push_back(i);
     }
 
-    // Enumerate solutions using functional approach
+    // Particular solution (all free variables 0) and one null-space vector
+    // per free variable: toggling free variable f flips f itself and every
+    // basic variable whose reduced row contains f.
+    typename Matrix::Row particular{};
+    for (int i = 0; i < rank; ++i)
+    {
+        if (Matrix::test(matrix.rows[i], numButtons))
+            Matrix::set(particular, pivotCol[i]);
+    }
+
     const int numFreeVars = freeVars.size();
-    if (numFreeVars > 20)
-        return 0;
+    vector<typename Matrix::Row> nullSpace(numFreeVars);
+    for (int f = 0; f < numFreeVars; ++f)
+    {
+        Matrix::set(nullSpace[f], freeVars[f]);
+        for (int i = 0; i < rank; ++i)
+        {
+            if (Matrix::test(matrix.rows[i], freeVars[f]))
+                Matrix::set(nullSpace[f], pivotCol[i]);
+        }
+    }
 
-    vector<int> allPresses;
-    allPresses.reserve(1 << numFreeVars);
+    if (mode == SolverMode::Auto)
+        mode = (numFreeVars <= MAX_GRAY_CODE_FREE_VARS) ? SolverMode::GrayCode : SolverMode::MeetInTheMiddle;
 
-    for (int mask = 0; mask < (1 << numFreeVars); ++mask)
+    if (mode == SolverMode::MeetInTheMiddle)
     {
-        vector<int> solution(numButtons, 0);
+        if (rank > 64)
+            throw runtime_error("Meet-in-the-middle needs rank <= 64, got " + to_string(rank));
 
-        for (int i = 0; i < numFreeVars; ++i)
+        // Restrict everything to the basic variables, one bit per pivot row
+        uint64_t particularBasics = 0;
+        vector<uint64_t> basicParts(numFreeVars, 0);
+        for (int i = 0; i < rank; ++i)
         {
-            solution[freeVars[i]] = (mask >> i) & 1;
+            if (Matrix::test(matrix.rows[i], numButtons))
+                particularBasics |= uint64_t(1) << i;
+            for (int f = 0; f < numFreeVars; ++f)
+            {
+                if (Matrix::test(matrix.rows[i], freeVars[f]))
+                    basicParts[f] |= uint64_t(1) << i;
+            }
         }
 
-        for (int i = rank - 1; i >= 0; --i)
-        {
-            int col = pivotCol[i];
-            if (col == -1)
-                continue;
+        return minWeightMeetInTheMiddle(particularBasics, basicParts, rank);
+    }
+
+    // Walk all free-variable assignments in Gray-code order: consecutive
+    // codes differ in one bit, so each step is a single XOR.
+    typename Matrix::Row solution = particular;
+    int minPresses = Matrix::popcount(solution);
+
+    for (uint64_t code = 1; code < (uint64_t(1) << numFreeVars); ++code)
+    {
+        Matrix::xorInto(solution, nullSpace[__builtin_ctzll(code)]);
+        minPresses = min(minPresses, Matrix::popcount(solution));
+    }
+
+    return minPresses;
+}
+
+// Dispatch on the number of 64-bit words needed per row
+int findMinPresses(const Machine &machine, SolverMode mode = SolverMode::Auto)
+{
+    const size_t bits = machine.numButtons + 1;
+
+    if (bits <= 64)
+        return findMinPressesPacked<1>(machine, mode);
+    if (bits <= 128)
+        return findMinPressesPacked<2>(machine, mode);
+    if (bits <= 256)
+        return findMinPressesPacked<4>(machine, mode);
+    if (bits <= 512)
+        return findMinPressesPacked<8>(machine, mode);
+
+    throw runtime_error("Too many buttons: " + to_string(machine.numButtons));
+}
 
-            int val = eliminatedMatrix[i][numButtons];
-            for (int j = col + 1; j < numButtons; ++j)
+// Compare meet-in-the-middle against Gray-code brute force on random
+// machines small enough to enumerate; returns the number of mismatches
+int crossCheckMeetInTheMiddle(int numMachines, unsigned seed)
+{
+    mt19937 rng(seed);
+    MachineArena arena;
+
+    for (int m = 0; m < numMachines; ++m)
+    {
+        const int numLights = 1 + rng() % 12;
+        const int numButtons = 1 + rng() % 22;
+
+        string line = "[";
+        for (int i = 0; i < numLights; ++i)
+            line += (rng() & 1) ? '#' : '.';
+        line += "]";
+
+        for (int b = 0; b < numButtons; ++b)
+        {
+            string button;
+            for (int i = 0; i < numLights; ++i)
             {
-                val ^= (eliminatedMatrix[i][j] & solution[j]);
+                if (rng() % 3 == 0)
+                    button += (button.empty() ? "" : ",") + to_string(i);
             }
-            solution[col] = val;
+            line += " (" + (button.empty() ? "0" : button) + ")";
         }
 
-        int totalPresses = accumulate(solution.begin(), solution.end(), 0);
-        allPresses.push_back(totalPresses);
+        arena.parseLine(line);
     }
 
-    return *min_element(allPresses.begin(), allPresses.end());
+    int mismatches = 0;
+    for (size_t m = 0; m < arena.size(); ++m)
+    {
+        const int expected = findMinPresses(arena[m], SolverMode::GrayCode);
+        const int actual = findMinPresses(arena[m], SolverMode::MeetInTheMiddle);
+        if (expected != actual)
+        {
+            print("MISMATCH on random machine", m, "- expected", expected, "got", actual);
+            ++mismatches;
+        }
+    }
+
+    return mismatches;
+}
+
+// Parse the manual repeatedly and report parse throughput
+void benchmarkParser(const vector<string> &lines, int repeats)
+{
+    size_t bytes = 0;
+    for (const auto &line : lines)
+        bytes += line.size() + 1;
+
+    auto [machines, ms] = timeMs([&]()
+                                 {
+        size_t parsed = 0;
+        for (int r = 0; r < repeats; ++r)
+        {
+            MachineArena arena;
+            for (const auto &line : lines)
+                arena.parseLine(line);
+            parsed += arena.size();
+        }
+        return parsed; });
+
+    print("Parsed", machines, "machines in", ms, "ms");
+    print("Throughput:", millionsPerSecond(machines, ms), "M lines/s,", millionsPerSecond(bytes * repeats, ms), "MB/s");
 }
 
 int main(int argc, char *argv[])
 {
+    // Benchmark mode: main bench [folder] [repeats]
+    if (argc > 1 && string(argv[1]) == "bench")
+    {
+        const string folder = (argc > 2) ? argv[2] : ".";
+        const int repeats = (argc > 3) ? stoi(argv[3]) : 2000;
+        benchmarkParser(readLines(folder + "/input.txt"), repeats);
+        return 0;
+    }
+
+    // Check mode: main check [machines]
+    if (argc > 1 && string(argv[1]) == "check")
+    {
+        const int machines = (argc > 2) ? stoi(argv[2]) : 5000;
+        const int mismatches = crossCheckMeetInTheMiddle(machines, 10);
+        print("Random machines:", machines, "- mismatched:", mismatches);
+        return mismatches == 0 ? 0 : 1;
+    }
+
     const string folder = (argc > 2) ? argv[2] : ".";
     const string filename = (argc > 1 && string(argv[1]) == "i") ? "input.txt" : "example.txt";
     const string inputFilePath = folder + "/" + filename;
@@ -362,19 +492,21 @@ int main(int argc, char *argv[])
 
     debug("Lines:", lines.size());
 
-    int idx = 0;
-    int totalMinPresses = accumulate(
-        lines.begin(),
-        lines.end(),
-        0,
-        [&idx](int total, const string &line) mutable
-        {
-            ++idx;
-            const auto machine = parseLine(line);
-            const int presses = findMinPresses(machine);
-            debug("Machine", idx, "- Min presses:", presses);
-            return total + presses;
-        });
+    MachineArena arena;
+    for (const auto &line : lines)
+        arena.parseLine(line);
+
+    // Solve machines on the work-stealing pool, then reduce in input order
+    vector<int> presses(arena.size());
+    parallelForStealing(arena.size(), [&](size_t idx)
+                        { presses[idx] = findMinPresses(arena[idx]); });
+
+    int totalMinPresses = 0;
+    for (size_t idx = 0; idx < presses.size(); ++idx)
+    {
+        debug("Machine", idx + 1, "- Min presses:", presses[idx]);
+        totalMinPresses += presses[idx];
+    }
 
     print("Total minimum presses:", totalMinPresses);
 
@@ -0,0 +1,127 @@
+/**
+ * Work-stealing parallel loop shared by Day 10, Day 10-2 and Day 12.
+ *
+ * Machines are independent but their solve times vary wildly, so static
+ * chunking leaves cores idle behind one slow machine. Each worker owns a
+ * contiguous range of indices and takes work from its front; a worker
+ * that runs dry steals the back half of the largest remaining range.
+ * Results are written by index, so callers can reduce them in input order
+ * and get the same answer regardless of scheduling.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+template <typename Task>
+void parallelForStealing(size_t count, Task task, unsigned numThreads = 0)
+{
+    if (numThreads == 0)
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    numThreads = std::max<size_t>(1, std::min<size_t>(numThreads, count));
+
+    struct Queue
+    {
+        std::mutex lock;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+
+    std::vector<Queue> queues(numThreads);
+    for (unsigned w = 0; w < numThreads; ++w)
+    {
+        queues[w].begin = count * w / numThreads;
+        queues[w].end = count * (w + 1) / numThreads;
+    }
+
+    std::mutex errorLock;
+    std::exception_ptr error;
+
+    // Take the next index from our own range
+    auto popOwn = [&](unsigned w, size_t &idx)
+    {
+        std::lock_guard<std::mutex> guard(queues[w].lock);
+        if (queues[w].begin == queues[w].end)
+            return false;
+        idx = queues[w].begin++;
+        return true;
+    };
+
+    // Move the back half of the fullest other range into ours
+    auto steal = [&](unsigned w)
+    {
+        unsigned victim = w;
+        size_t largest = 0;
+        for (unsigned v = 0; v < numThreads; ++v)
+        {
+            if (v == w)
+                continue;
+            std::lock_guard<std::mutex> guard(queues[v].lock);
+            if (queues[v].end - queues[v].begin > largest)
+            {
+                largest = queues[v].end - queues[v].begin;
+                victim = v;
+            }
+        }
+
+        if (victim == w)
+            return false;
+
+        size_t from, to;
+        {
+            std::lock_guard<std::mutex> guard(queues[victim].lock);
+            const size_t remaining = queues[victim].end - queues[victim].begin;
+            if (remaining == 0)
+                return true; // raced with the owner; look again
+            from = queues[victim].end - (remaining + 1) / 2;
+            to = queues[victim].end;
+            queues[victim].end = from;
+        }
+
+        std::lock_guard<std::mutex> guard(queues[w].lock);
+        queues[w].begin = from;
+        queues[w].end = to;
+        return true;
+    };
+
+    auto worker = [&](unsigned w)
+    {
+        size_t idx;
+        while (true)
+        {
+            if (!popOwn(w, idx))
+            {
+                if (!steal(w))
+                    return;
+                continue;
+            }
+
+            try
+            {
+                task(idx);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> guard(errorLock);
+                if (!error)
+                    error = std::current_exception();
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned w = 1; w < numThreads; ++w)
+        threads.emplace_back(worker, w);
+    worker(0);
+
+    for (auto &thread : threads)
+        thread.join();
+
+    if (error)
+        std::rethrow_exception(error);
+}
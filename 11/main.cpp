@@ -2,19 +2,109 @@
 #include <fstream>
 #include <string>
 #include <vector>
-#include <map>
-#include <set>
 #include <sstream>
 #include <algorithm>
+#include <unordered_map>
+#include <list>
+#include <cstdint>
+#include <stdexcept>
+#include <chrono>
 
 using namespace std;
 
-typedef map<string, vector<string>> Graph;
-typedef set<string> StringSet;
+const uint32_t NO_NODE = UINT32_MAX;
+
+// Device graph with names interned to dense IDs and adjacency stored in
+// compressed sparse row form: the outputs of node v are
+// targets[offsets[v] .. offsets[v + 1]), and likewise for the inputs in the
+// reverse arrays.
+struct Graph
+{
+    vector<string> names;
+    unordered_map<string, uint32_t> ids;
+    vector<uint32_t> offsets;
+    vector<uint32_t> targets;
+    vector<uint32_t> reverse_offsets;
+    vector<uint32_t> reverse_targets;
+
+    size_t size() const
+    {
+        return names.size();
+    }
+
+    uint32_t id(const string &name) const
+    {
+        auto it = ids.find(name);
+        return it == ids.end() ? NO_NODE : it->second;
+    }
+};
+
+typedef vector<uint64_t> Bitset;
+
+// Path counts grow exponentially with graph depth, so they are kept in 128 bits
+typedef unsigned __int128 PathCount;
+
+string to_string(PathCount value)
+{
+    if (value == 0)
+    {
+        return "0";
+    }
+    string digits;
+    while (value > 0)
+    {
+        digits += char('0' + (int)(value % 10));
+        value /= 10;
+    }
+    reverse(digits.begin(), digits.end());
+    return digits;
+}
+
+ostream &operator<<(ostream &out, PathCount value)
+{
+    return out << to_string(value);
+}
+
+inline bool bitset_test(const Bitset &bits, uint32_t node)
+{
+    return (bits[node >> 6] >> (node & 63)) & 1;
+}
+
+inline void bitset_set(Bitset &bits, uint32_t node)
+{
+    bits[node >> 6] |= uint64_t(1) << (node & 63);
+}
+
+uint32_t intern(Graph &graph, const string &name)
+{
+    auto [it, inserted] = graph.ids.emplace(name, (uint32_t)graph.names.size());
+    if (inserted)
+    {
+        graph.names.push_back(name);
+    }
+    return it->second;
+}
+
+// Build CSR arrays from per-node adjacency lists with a counting pass
+void build_csr(const vector<vector<uint32_t>> &adjacency, vector<uint32_t> &offsets, vector<uint32_t> &targets)
+{
+    offsets.assign(adjacency.size() + 1, 0);
+    for (size_t v = 0; v < adjacency.size(); v++)
+    {
+        offsets[v + 1] = offsets[v] + adjacency[v].size();
+    }
+
+    targets.resize(offsets.back());
+    for (size_t v = 0; v < adjacency.size(); v++)
+    {
+        copy(adjacency[v].begin(), adjacency[v].end(), targets.begin() + offsets[v]);
+    }
+}
 
 Graph parse_input(const string &content)
 {
     Graph graph;
+    vector<vector<uint32_t>> adjacency;
     istringstream stream(content);
     string line;
 
@@ -32,52 +122,55 @@ Graph parse_input(const string &content)
         device.erase(device.find_last_not_of(" \t") + 1);
         device.erase(0, device.find_first_not_of(" \t"));
 
-        string outputs_str = line.substr(colon_pos + 1);
-        vector<string> outputs;
-        istringstream outputs_stream(outputs_str);
+        uint32_t source = intern(graph, device);
+        vector<uint32_t> outputs;
+        istringstream outputs_stream(line.substr(colon_pos + 1));
         string output;
         while (outputs_stream >> output)
         {
-            outputs.push_back(output);
+            outputs.push_back(intern(graph, output));
         }
 
-        graph[device] = outputs;
+        adjacency.resize(graph.size());
+        // A repeated device line replaces the earlier one
+        adjacency[source] = move(outputs);
     }
 
-    return graph;
-}
-
-// Build reverse graph and compute reachable nodes
-StringSet compute_reachable(const Graph &graph, const string &target)
-{
-    StringSet reachable;
-    vector<string> queue;
-    queue.push_back(target);
-    reachable.insert(target);
+    adjacency.resize(graph.size());
+    build_csr(adjacency, graph.offsets, graph.targets);
 
-    // Build reverse graph
-    map<string, vector<string>> reverse_graph;
-    for (const auto &[node, neighbors] : graph)
+    vector<vector<uint32_t>> reverse_adjacency(graph.size());
+    for (uint32_t node = 0; node < graph.size(); node++)
     {
-        for (const auto &neighbor : neighbors)
+        for (uint32_t neighbor : adjacency[node])
         {
-            reverse_graph[neighbor].push_back(node);
+            reverse_adjacency[neighbor].push_back(node);
         }
     }
+    build_csr(reverse_adjacency, graph.reverse_offsets, graph.reverse_targets);
+
+    return graph;
+}
+
+// Nodes that can reach the target, via BFS over the reverse CSR
+Bitset compute_reachable(const Graph &graph, uint32_t target)
+{
+    Bitset reachable((graph.size() + 63) / 64, 0);
+    vector<uint32_t> queue;
+    queue.push_back(target);
+    bitset_set(reachable, target);
 
     size_t idx = 0;
     while (idx < queue.size())
     {
-        string current = queue[idx++];
-        if (reverse_graph.find(current) != reverse_graph.end())
+        uint32_t current = queue[idx++];
+        for (uint32_t e = graph.reverse_offsets[current]; e < graph.reverse_offsets[current + 1]; e++)
         {
-            for (const auto &pred : reverse_graph[current])
+            uint32_t pred = graph.reverse_targets[e];
+            if (!bitset_test(reachable, pred))
             {
-                if (reachable.find(pred) == reachable.end())
-                {
-                    reachable.insert(pred);
-                    queue.push_back(pred);
-                }
+                bitset_set(reachable, pred);
+                queue.push_back(pred);
             }
         }
     }
@@ -85,204 +178,568 @@ StringSet compute_reachable(const Graph &graph, const string &target)
     return reachable;
 }
 
-size_t count_paths(
-    const Graph &graph,
-    const string &current,
-    const string &target,
-    StringSet &visited,
-    const StringSet &reachable)
+// Reachability to several targets at once: each node holds one bit-lane
+// per target (bit i of its words = the node can reach targets[i]).
+struct MultiReachability
 {
+    size_t words_per_node = 0;
+    vector<uint64_t> lanes; // node * words_per_node + word
 
-    if (current == target)
+    bool test(uint32_t node, size_t target_index) const
     {
-        return 1;
+        return (lanes[node * words_per_node + (target_index >> 6)] >> (target_index & 63)) & 1;
     }
 
-    visited.insert(current);
+    // Dense per-node bitset for one target, for bitset_test
+    Bitset to_bitset(const Graph &graph, size_t target_index) const
+    {
+        Bitset reachable((graph.size() + 63) / 64, 0);
+        for (uint32_t node = 0; node < graph.size(); node++)
+        {
+            if (test(node, target_index))
+            {
+                bitset_set(reachable, node);
+            }
+        }
+        return reachable;
+    }
+};
 
-    size_t total_paths = 0;
+// One sweep over the reverse CSR for all targets together: a node's lanes
+// are ORed into each predecessor, which is requeued only when that adds a
+// bit. Also correct on cyclic graphs.
+MultiReachability compute_reachable_multi(const Graph &graph, const vector<uint32_t> &targets)
+{
+    MultiReachability result;
+    const size_t words = max<size_t>(1, (targets.size() + 63) / 64);
+    result.words_per_node = words;
+    result.lanes.assign(graph.size() * words, 0);
+
+    vector<uint32_t> queue;
+    vector<char> queued(graph.size(), 0);
+    for (size_t i = 0; i < targets.size(); i++)
+    {
+        result.lanes[targets[i] * words + (i >> 6)] |= uint64_t(1) << (i & 63);
+        if (!queued[targets[i]])
+        {
+            queued[targets[i]] = 1;
+            queue.push_back(targets[i]);
+        }
+    }
 
-    if (graph.find(current) != graph.end())
+    size_t idx = 0;
+    while (idx < queue.size())
     {
-        for (const auto &neighbor : graph.at(current))
+        uint32_t current = queue[idx++];
+        queued[current] = 0;
+        const uint64_t *from = &result.lanes[current * words];
+
+        for (uint32_t e = graph.reverse_offsets[current]; e < graph.reverse_offsets[current + 1]; e++)
         {
-            if (visited.find(neighbor) == visited.end() && reachable.find(neighbor) != reachable.end())
+            uint32_t pred = graph.reverse_targets[e];
+            uint64_t *to = &result.lanes[pred * words];
+            uint64_t added = 0;
+            for (size_t w = 0; w < words; w++)
             {
-                total_paths += count_paths(graph, neighbor, target, visited, reachable);
+                added |= from[w] & ~to[w];
+                to[w] |= from[w];
+            }
+            if (added && !queued[pred])
+            {
+                queued[pred] = 1;
+                queue.push_back(pred);
             }
         }
     }
 
-    visited.erase(current);
-
-    return total_paths;
+    return result;
 }
 
-size_t count_paths_with_required(
-    const Graph &graph,
-    const string &current,
-    const string &target,
-    const vector<string> &required,
-    StringSet &visited,
-    StringSet &found_required,
-    const StringSet &reachable_target,
-    const vector<StringSet> &reachable_req,
-    map<pair<string, unsigned char>, size_t> &memo,
-    size_t &call_count)
+// Kahn's algorithm. Returns false if the graph has a cycle, in which case
+// order holds only the nodes that are not on or behind a cycle.
+bool topological_order(const Graph &graph, vector<uint32_t> &order)
 {
-
-    call_count++;
-    if (call_count % 100000 == 0)
+    vector<uint32_t> in_degree(graph.size());
+    for (uint32_t neighbor : graph.targets)
     {
-        cout << "  Processed " << call_count << " nodes..." << endl;
+        in_degree[neighbor]++;
     }
 
-    // Check if current node is one of the required nodes
-    bool is_required = find(required.begin(), required.end(), current) != required.end();
-    if (is_required)
+    order.clear();
+    order.reserve(graph.size());
+    for (uint32_t node = 0; node < graph.size(); node++)
     {
-        found_required.insert(current);
+        if (in_degree[node] == 0)
+        {
+            order.push_back(node);
+        }
     }
 
-    // If we reached the target, check if we visited all required nodes
-    if (current == target)
+    for (size_t idx = 0; idx < order.size(); idx++)
     {
-        bool all_found = true;
-        for (const auto &req : required)
+        uint32_t current = order[idx];
+        for (uint32_t e = graph.offsets[current]; e < graph.offsets[current + 1]; e++)
         {
-            if (found_required.find(req) == found_required.end())
+            uint32_t neighbor = graph.targets[e];
+            if (--in_degree[neighbor] == 0)
             {
-                all_found = false;
-                break;
+                order.push_back(neighbor);
             }
         }
-        if (is_required)
-        {
-            found_required.erase(current);
-        }
-        return all_found ? 1 : 0;
     }
 
-    // Pruning: check if we can still reach target
-    if (reachable_target.find(current) == reachable_target.end())
+    return order.size() == graph.size();
+}
+
+// Name one node that Kahn's algorithm could not order, for error reporting
+string describe_cycle(const Graph &graph, const vector<uint32_t> &order)
+{
+    vector<char> ordered(graph.size(), 0);
+    for (uint32_t node : order)
     {
-        if (is_required)
+        ordered[node] = 1;
+    }
+
+    size_t blocked = graph.size() - order.size();
+    for (uint32_t node = 0; node < graph.size(); node++)
+    {
+        if (!ordered[node])
         {
-            found_required.erase(current);
+            return to_string(blocked) + " nodes on or behind a cycle, e.g. " + graph.names[node];
         }
-        return 0;
     }
+    return "no cycle";
+}
 
-    // Pruning: check if we can reach all missing required nodes
-    for (size_t i = 0; i < required.size(); i++)
+// Count source -> target paths in a DAG with one pass in reverse
+// topological order: paths[v] = sum of paths[w] over the outputs w of v.
+PathCount count_paths_dag(const Graph &graph, const vector<uint32_t> &order, uint32_t source, uint32_t target)
+{
+    vector<PathCount> paths(graph.size(), 0);
+    paths[target] = 1;
+
+    for (size_t idx = order.size(); idx-- > 0;)
     {
-        if (found_required.find(required[i]) == found_required.end() &&
-            reachable_req[i].find(current) == reachable_req[i].end())
+        uint32_t current = order[idx];
+        if (current == target)
         {
-            if (is_required)
+            continue;
+        }
+
+        PathCount total = 0;
+        for (uint32_t e = graph.offsets[current]; e < graph.offsets[current + 1]; e++)
+        {
+            if (__builtin_add_overflow(total, paths[graph.targets[e]], &total))
             {
-                found_required.erase(current);
+                throw overflow_error("Path count exceeds 128 bits at " + graph.names[current]);
             }
-            return 0;
         }
+        paths[current] = total;
     }
 
-    // Create a bitmask for found_required state
-    unsigned char state_mask = 0;
-    for (size_t i = 0; i < required.size(); i++)
+    return paths[source];
+}
+
+// Simple-path enumeration; only used when the graph has a cycle
+size_t count_paths(
+    const Graph &graph,
+    uint32_t current,
+    uint32_t target,
+    vector<char> &visited,
+    const Bitset &reachable)
+{
+
+    if (current == target)
     {
-        if (found_required.find(required[i]) != found_required.end())
-        {
-            state_mask |= (1 << i);
-        }
+        return 1;
     }
 
-    pair<string, unsigned char> memo_key = {current, state_mask};
-    if (memo.find(memo_key) != memo.end())
+    visited[current] = 1;
+
+    size_t total_paths = 0;
+
+    for (uint32_t e = graph.offsets[current]; e < graph.offsets[current + 1]; e++)
     {
-        if (is_required)
+        uint32_t neighbor = graph.targets[e];
+        if (!visited[neighbor] && bitset_test(reachable, neighbor))
         {
-            found_required.erase(current);
+            total_paths += count_paths(graph, neighbor, target, visited, reachable);
         }
-        return memo[memo_key];
     }
 
-    visited.insert(current);
+    visited[current] = 0;
 
-    size_t total_paths = 0;
+    return total_paths;
+}
 
-    if (graph.find(current) != graph.end())
+// The DFS fallback for cyclic graphs tracks the waypoints seen so far as bits
+// of a 32-bit mask; the DAG path has no limit
+const size_t MAX_REQUIRED = 31;
+
+// Per node: a bit for each required node it is, 0 for ordinary nodes
+vector<uint32_t> required_bits(const Graph &graph, const vector<uint32_t> &required)
+{
+    vector<uint32_t> bits(graph.size(), 0);
+    for (size_t i = 0; i < required.size(); i++)
+    {
+        bits[required[i]] |= 1u << i;
+    }
+    return bits;
+}
+
+// Count source -> target paths that pass through every required node. In a
+// DAG a path meets its waypoints in topological order, so the count is the
+// product of the path counts between consecutive waypoints sorted by
+// position. O(k * (V+E)) for k waypoints, with no limit on k.
+PathCount count_paths_with_required_dag(
+    const Graph &graph,
+    const vector<uint32_t> &order,
+    uint32_t source,
+    uint32_t target,
+    vector<uint32_t> required)
+{
+    vector<uint32_t> position(graph.size(), 0);
+    for (size_t idx = 0; idx < order.size(); idx++)
     {
-        for (const auto &neighbor : graph.at(current))
+        position[order[idx]] = idx;
+    }
+    sort(required.begin(), required.end(), [&](uint32_t a, uint32_t b)
+         { return position[a] < position[b]; });
+    required.erase(unique(required.begin(), required.end()), required.end());
+    required.push_back(target);
+
+    PathCount total = 1;
+    uint32_t from = source;
+    for (uint32_t to : required)
+    {
+        PathCount segment = count_paths_dag(graph, order, from, to);
+        if (segment == 0)
         {
-            if (visited.find(neighbor) == visited.end())
-            {
-                total_paths += count_paths_with_required(
-                    graph, neighbor, target, required, visited, found_required,
-                    reachable_target, reachable_req, memo, call_count);
-            }
+            return 0;
+        }
+        if (__builtin_mul_overflow(total, segment, &total))
+        {
+            throw overflow_error("Path count exceeds 128 bits");
         }
+        from = to;
+    }
+    return total;
+}
+
+// Simple-path enumeration tracking the required nodes seen so far; only
+// used when the graph has a cycle
+PathCount count_paths_with_required(
+    const Graph &graph,
+    uint32_t current,
+    uint32_t target,
+    const vector<uint32_t> &bits,
+    uint32_t found_mask,
+    uint32_t all_required,
+    vector<char> &visited,
+    const Bitset &reachable)
+{
+    found_mask |= bits[current];
+    if (current == target)
+    {
+        return found_mask == all_required ? 1 : 0;
     }
 
-    visited.erase(current);
+    visited[current] = 1;
 
-    if (is_required)
+    PathCount total_paths = 0;
+    for (uint32_t e = graph.offsets[current]; e < graph.offsets[current + 1]; e++)
     {
-        found_required.erase(current);
+        uint32_t neighbor = graph.targets[e];
+        if (!visited[neighbor] && bitset_test(reachable, neighbor))
+        {
+            total_paths += count_paths_with_required(graph, neighbor, target, bits, found_mask, all_required, visited, reachable);
+        }
     }
 
-    memo[memo_key] = total_paths;
+    visited[current] = 0;
 
     return total_paths;
 }
 
-size_t solve(const string &content)
+PathCount solve(const string &content)
 {
     Graph graph = parse_input(content);
-    StringSet reachable = compute_reachable(graph, "out");
-    StringSet visited;
-    return count_paths(graph, "you", "out", visited, reachable);
+    uint32_t start = graph.id("you");
+    uint32_t target = graph.id("out");
+    if (start == NO_NODE || target == NO_NODE)
+    {
+        return 0;
+    }
+
+    vector<uint32_t> order;
+    if (topological_order(graph, order))
+    {
+        return count_paths_dag(graph, order, start, target);
+    }
+
+    cout << "Graph is not a DAG (" << describe_cycle(graph, order) << "), falling back to DFS" << endl;
+    Bitset reachable = compute_reachable(graph, target);
+    vector<char> visited(graph.size(), 0);
+    return count_paths(graph, start, target, visited, reachable);
 }
 
-size_t solve_part2(const string &content)
+PathCount solve_part2(const string &content, const vector<string> &required_names = {"dac", "fft"})
 {
     Graph graph = parse_input(content);
 
     cout << "Calculating Part 2... (analyzing graph)" << endl;
 
-    StringSet reachable_target = compute_reachable(graph, "out");
-    StringSet reachable_dac = compute_reachable(graph, "dac");
-    StringSet reachable_fft = compute_reachable(graph, "fft");
-    vector<StringSet> reachable_req = {reachable_dac, reachable_fft};
+    uint32_t start = graph.id("svr");
+    uint32_t target = graph.id("out");
+    vector<uint32_t> required;
+    for (const auto &name : required_names)
+    {
+        required.push_back(graph.id(name));
+    }
 
-    // Quick check: if svr can't reach required nodes or target, return 0
-    if (reachable_target.find("svr") == reachable_target.end())
+    if (start == NO_NODE || target == NO_NODE ||
+        find(required.begin(), required.end(), NO_NODE) != required.end())
     {
-        cout << "SVR cannot reach OUT" << endl;
+        cout << "Missing svr, out or a required node" << endl;
         return 0;
     }
-    if (reachable_dac.find("svr") == reachable_dac.end())
+
+    // Reachability to out (lane 0) and every required node, in one sweep
+    vector<uint32_t> reach_targets = {target};
+    reach_targets.insert(reach_targets.end(), required.begin(), required.end());
+    MultiReachability reachability = compute_reachable_multi(graph, reach_targets);
+
+    // Quick check: if svr can't reach required nodes or target, return 0
+    if (!reachability.test(start, 0))
     {
-        cout << "SVR cannot reach dac" << endl;
+        cout << "SVR cannot reach OUT" << endl;
         return 0;
     }
-    if (reachable_fft.find("svr") == reachable_fft.end())
+    for (size_t i = 0; i < required.size(); i++)
     {
-        cout << "SVR cannot reach fft" << endl;
-        return 0;
+        if (!reachability.test(start, i + 1))
+        {
+            cout << "SVR cannot reach " << required_names[i] << endl;
+            return 0;
+        }
     }
 
     cout << "Graph analysis complete. Searching paths..." << endl;
 
-    StringSet visited;
-    vector<string> required = {"dac", "fft"};
-    StringSet found_required;
-    map<pair<string, unsigned char>, size_t> memo;
-    size_t call_count = 0;
+    vector<uint32_t> order;
+    if (topological_order(graph, order))
+    {
+        return count_paths_with_required_dag(graph, order, start, target, required);
+    }
 
-    return count_paths_with_required(
-        graph, "svr", "out", required, visited, found_required,
-        reachable_target, reachable_req, memo, call_count);
+    cout << "Graph is not a DAG (" << describe_cycle(graph, order) << "), falling back to DFS" << endl;
+    if (required.size() > MAX_REQUIRED)
+    {
+        throw runtime_error("Too many required nodes: " + to_string(required.size()));
+    }
+    vector<char> visited(graph.size(), 0);
+    return count_paths_with_required(graph, start, target, required_bits(graph, required), 0,
+                                     (1u << required.size()) - 1, visited, reachability.to_bitset(graph, 0));
+}
+
+// Memory allowed for cached per-target path counts. Each entry holds one
+// count per node, so the number of cached targets shrinks as graphs grow.
+const size_t PATHS_CACHE_BYTES = size_t(64) << 20;
+
+// Answers many "paths from X to Y through Z..." queries against one graph.
+//
+// The graph is parsed and topologically sorted once. For each target that
+// is queried, the vector of path counts from every node to it is computed
+// with count_paths_dag's recurrence and cached; a nonzero entry doubles as
+// "can reach the target". In a DAG, a path visits its waypoints in
+// topological order, so a query with waypoints is the product of the
+// segment counts between consecutive waypoints sorted by position.
+class PathQueryEngine
+{
+public:
+    explicit PathQueryEngine(const string &content)
+        : graph(parse_input(content))
+    {
+        max_cached = max<size_t>(1, PATHS_CACHE_BYTES / (max<size_t>(1, graph.size()) * sizeof(PathCount)));
+        is_dag = topological_order(graph, order);
+        position.assign(graph.size(), 0);
+        for (size_t idx = 0; idx < order.size(); idx++)
+        {
+            position[order[idx]] = idx;
+        }
+        if (!is_dag)
+        {
+            cout << "Graph is not a DAG (" << describe_cycle(graph, order) << "), queries fall back to DFS" << endl;
+        }
+    }
+
+    const Graph &get_graph() const
+    {
+        return graph;
+    }
+
+    size_t cached_targets() const
+    {
+        return paths_to.size();
+    }
+
+    PathCount query(uint32_t source, uint32_t target, vector<uint32_t> via)
+    {
+        if (!is_dag)
+        {
+            if (via.size() > MAX_REQUIRED)
+            {
+                throw runtime_error("Too many required nodes: " + to_string(via.size()));
+            }
+            vector<char> visited(graph.size(), 0);
+            return count_paths_with_required(graph, source, target, required_bits(graph, via), 0,
+                                             (1u << via.size()) - 1, visited, compute_reachable(graph, target));
+        }
+
+        sort(via.begin(), via.end(), [&](uint32_t a, uint32_t b)
+             { return position[a] < position[b]; });
+        via.erase(unique(via.begin(), via.end()), via.end());
+
+        PathCount total = 1;
+        uint32_t from = source;
+        via.push_back(target);
+        for (uint32_t to : via)
+        {
+            PathCount segment = paths_to_target(to)[from];
+            if (segment == 0)
+            {
+                return 0;
+            }
+            if (__builtin_mul_overflow(total, segment, &total))
+            {
+                throw overflow_error("Path count exceeds 128 bits");
+            }
+            from = to;
+        }
+        return total;
+    }
+
+private:
+    Graph graph;
+    vector<uint32_t> order;
+    vector<uint32_t> position; // index of each node in order
+    bool is_dag = false;
+
+    // Least recently used cache of paths_to_target results, most recent first
+    struct CachedPaths
+    {
+        vector<PathCount> paths;
+        list<uint32_t>::iterator recency;
+    };
+    unordered_map<uint32_t, CachedPaths> paths_to;
+    list<uint32_t> recently_used;
+    size_t max_cached = 1;
+
+    // The returned reference is valid until the next call
+    const vector<PathCount> &paths_to_target(uint32_t target)
+    {
+        auto it = paths_to.find(target);
+        if (it != paths_to.end())
+        {
+            recently_used.splice(recently_used.begin(), recently_used, it->second.recency);
+            return it->second.paths;
+        }
+
+        vector<PathCount> paths(graph.size(), 0);
+        paths[target] = 1;
+        // Only nodes before the target in topological order can reach it
+        for (size_t idx = position[target]; idx-- > 0;)
+        {
+            uint32_t current = order[idx];
+            PathCount total = 0;
+            for (uint32_t e = graph.offsets[current]; e < graph.offsets[current + 1]; e++)
+            {
+                if (__builtin_add_overflow(total, paths[graph.targets[e]], &total))
+                {
+                    throw overflow_error("Path count exceeds 128 bits at " + graph.names[current]);
+                }
+            }
+            paths[current] = total;
+        }
+
+        if (paths_to.size() >= max_cached)
+        {
+            paths_to.erase(recently_used.back());
+            recently_used.pop_back();
+        }
+        recently_used.push_front(target);
+        return paths_to.emplace(target, CachedPaths{move(paths), recently_used.begin()}).first->second.paths;
+    }
+};
+
+// Query mode: one query per line, "SOURCE TARGET [VIA...]". Blank lines and
+// lines starting with '#' are skipped. Prints each answer with its latency.
+void run_queries(const string &graph_content, istream &queries)
+{
+    auto load_start = chrono::high_resolution_clock::now();
+    PathQueryEngine engine(graph_content);
+    auto load_end = chrono::high_resolution_clock::now();
+    const Graph &graph = engine.get_graph();
+    cout << "Loaded " << graph.size() << " devices, " << graph.targets.size() << " connections in "
+         << chrono::duration<double, milli>(load_end - load_start).count() << " ms" << endl;
+
+    size_t query_count = 0;
+    double total_us = 0;
+    double max_us = 0;
+    string line;
+    while (getline(queries, line))
+    {
+        istringstream fields(line);
+        vector<string> names;
+        string name;
+        while (fields >> name)
+        {
+            names.push_back(name);
+        }
+        if (names.empty() || names[0][0] == '#')
+            continue;
+
+        if (names.size() < 2)
+        {
+            cout << line << ": expected SOURCE TARGET [VIA...]" << endl;
+            continue;
+        }
+
+        auto start = chrono::high_resolution_clock::now();
+        vector<uint32_t> ids;
+        string unknown;
+        for (const auto &device : names)
+        {
+            ids.push_back(graph.id(device));
+            if (ids.back() == NO_NODE && unknown.empty())
+            {
+                unknown = device;
+            }
+        }
+
+        PathCount result = 0;
+        if (unknown.empty())
+        {
+            result = engine.query(ids[0], ids[1], vector<uint32_t>(ids.begin() + 2, ids.end()));
+        }
+        auto end = chrono::high_resolution_clock::now();
+        double us = chrono::duration<double, micro>(end - start).count();
+
+        query_count++;
+        total_us += us;
+        max_us = max(max_us, us);
+
+        cout << line << ": " << result;
+        if (!unknown.empty())
+        {
+            cout << " (unknown device " << unknown << ")";
+        }
+        cout << " [" << us << " us]" << endl;
+    }
+
+    cout << "Queries: " << query_count << ", total " << total_us / 1000.0 << " ms, mean "
+         << (query_count ? total_us / query_count : 0.0) << " us, max " << max_us << " us, cached targets "
+         << engine.cached_targets() << endl;
 }
 
 string read_file(const string &path)
@@ -297,14 +754,35 @@ string read_file(const string &path)
     return buffer.str();
 }
 
-int main()
+int main(int argc, char *argv[])
 {
+    // Query mode: answer path-count queries from a file, or stdin if none or
+    // "-", against the puzzle input or the given graph file
+    if (argc > 1 && string(argv[1]) == "query")
+    {
+        string graph_content = read_file((argc > 3) ? argv[3] : "11/input.txt");
+        if (argc > 2 && string(argv[2]) != "-")
+        {
+            ifstream queries(argv[2]);
+            if (!queries.is_open())
+            {
+                throw runtime_error("Failed to read file: " + string(argv[2]));
+            }
+            run_queries(graph_content, queries);
+        }
+        else
+        {
+            run_queries(graph_content, cin);
+        }
+        return 0;
+    }
+
     cout << "=== Part 1 ===" << endl;
 
     // Run example.txt first
     cout << "Running example.txt..." << endl;
     string example_content = read_file("11/example.txt");
-    size_t example_result = solve(example_content);
+    PathCount example_result = solve(example_content);
     cout << "Example result: " << example_result << endl;
 
     // Check if example result matches expected (5)
@@ -322,7 +800,7 @@ int main()
     // Run input.txt
     cout << "Running input.txt..." << endl;
     string input_content = read_file("11/input.txt");
-    size_t input_result = solve(input_content);
+    PathCount input_result = solve(input_content);
     cout << "Part 1 answer: " << input_result << endl
          << endl;
 
@@ -331,7 +809,7 @@ int main()
     // Run example2.txt first
     cout << "Running example2.txt..." << endl;
     string example2_content = read_file("11/example2.txt");
-    size_t example2_result = solve_part2(example2_content);
+    PathCount example2_result = solve_part2(example2_content);
     cout << "Example result: " << example2_result << endl;
 
     // Check if example result matches expected (2)
@@ -348,7 +826,7 @@ int main()
 
     // Run input.txt for part 2
     cout << "Running input.txt..." << endl;
-    size_t input_result2 = solve_part2(input_content);
+    PathCount input_result2 = solve_part2(input_content);
     cout << "Part 2 answer: " << input_result2 << endl;
 
     return 0;